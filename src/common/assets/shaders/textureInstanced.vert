@@ -0,0 +1,13 @@
+attribute vec3 vertPosition;
+attribute vec2 vertTexCoord;
+// One per instance, rather than a uniform for each draw call
+attribute mat4 instanceModelView;
+
+uniform mat4 projection;
+
+varying vec2 texCoord;
+
+void main() {
+  gl_Position = projection * instanceModelView * vec4(vertPosition, 1.0);
+  texCoord = vertTexCoord;
+}
@@ -78,6 +78,9 @@ namespace ld2016 {
        * \return The projection matrix transform.
        */
       virtual glm::mat4 projection(float aspect, float alpha = 1.0f) const = 0;
+
+      // Cameras only look
+      virtual Extent bounds(Bounds *bounds) const { return EXTENT_NOTHING; }
   };
 }
 
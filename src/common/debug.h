@@ -90,6 +90,8 @@ namespace ld2016 {
       void draw(const glm::mat4 &modelWorld,
           const glm::mat4 &worldView, const glm::mat4 &projection,
           float alpha, bool debug);
+      // Lines and points may be anywhere
+      Extent bounds(Bounds *bounds) const { return EXTENT_UNBOUNDED; }
   };
 }
 
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <cstdlib>
+#include "ecsArchetypes.h"
+
+namespace ecs {
+
+  template<typename compType>
+  static void moveConstructComp(void* dst, void* src) {
+    new (dst) compType(std::move(*reinterpret_cast<compType*>(src)));
+  }
+  template<typename compType>
+  static void destroyComp(void* comp) {
+    reinterpret_cast<compType*>(comp)->~compType();
+  }
+
+  template<typename ... comps>
+  static const CompTypeInfo* compTypeInfoTable(CompList<comps...>) {
+    static const CompTypeInfo table[] = {
+      { sizeof(comps), alignof(comps), &moveConstructComp<comps>, &destroyComp<comps> }...
+    };
+    return table;
+  }
+
+  const CompTypeInfo& getCompTypeInfo(uint32_t compIndex) {
+    assert(compIndex < numCompTypes);
+    return compTypeInfoTable(AllComps())[compIndex];
+  }
+
+  static inline size_t alignUp(size_t offset, size_t align) {
+    return (offset + align - 1) & ~(align - 1);
+  }
+
+  /*
+   * Loops over the index of every component column present in 'mask' (that is, every component but Existence).
+   */
+  #define FOR_EACH_COLUMN(index, mask) \
+    for (uint32_t index = 0; index < numCompTypes; ++index) \
+      if ((mask).test(index) && CompMask::bit(index) != ENUM_Existence)
+
+  Archetype::Archetype(const compMask& mask) : mask(mask) {
+    size_t rowSize = sizeof(entityId);
+    FOR_EACH_COLUMN(i, mask) {
+      assert(getCompTypeInfo(i).align <= alignof(std::max_align_t));
+      rowSize += getCompTypeInfo(i).size;
+    }
+    // Start with as many rows as would fit without padding, then back off until the aligned columns fit in a chunk.
+    for (capacity = (uint32_t)(ECS_ARCHETYPE_CHUNK_SIZE / rowSize); capacity; --capacity) {
+      size_t offset = sizeof(entityId) * capacity;
+      FOR_EACH_COLUMN(i, mask) {
+        offset = alignUp(offset, getCompTypeInfo(i).align);
+        columnOffsets[i] = (uint32_t)offset;
+        offset += getCompTypeInfo(i).size * capacity;
+      }
+      if (offset <= ECS_ARCHETYPE_CHUNK_SIZE) {
+        break;
+      }
+    }
+    assert(capacity && "Components too large to fit a single entity into an archetype chunk");
+  }
+
+  Archetype::~Archetype() {
+    for (auto& chunk : chunks) {
+      for (uint32_t row = 0; row < chunk.count; ++row) {
+        FOR_EACH_COLUMN(i, mask) {
+          getCompTypeInfo(i).destroy(at(i, (uint32_t)(&chunk - &chunks[0]), row));
+        }
+      }
+      free(chunk.data);
+    }
+  }
+
+  uint32_t Archetype::pushRow(const entityId& id, uint32_t* chunkIndex) {
+    if (chunks.empty() || chunks.back().count == capacity) {
+      ArchetypeChunk chunk;
+      chunk.data = (unsigned char*) malloc(ECS_ARCHETYPE_CHUNK_SIZE);
+      assert(chunk.data);
+      chunk.count = 0;
+      chunk.archetype = this;
+      chunks.push_back(chunk);
+    }
+    *chunkIndex = (uint32_t) chunks.size() - 1;
+    ArchetypeChunk& chunk = chunks.back();
+    chunk.ids()[chunk.count] = id;
+    return chunk.count++;
+  }
+
+  /*
+   * Fills the hole at 'row' with the last row of the last chunk. The components at 'row' must already have been
+   * destroyed (or moved out). Returns the ID of the entity that was moved into the hole, or 0 if none was moved.
+   */
+  entityId Archetype::popRow(uint32_t chunkIndex, uint32_t row) {
+    uint32_t lastChunk = (uint32_t) chunks.size() - 1;
+    uint32_t lastRow = chunks[lastChunk].count - 1;
+    entityId movedId = 0;
+    if (chunkIndex != lastChunk || row != lastRow) {
+      FOR_EACH_COLUMN(i, mask) {
+        void* last = at(i, lastChunk, lastRow);
+        getCompTypeInfo(i).moveConstruct(at(i, chunkIndex, row), last);
+        getCompTypeInfo(i).destroy(last);
+      }
+      movedId = chunks[lastChunk].ids()[lastRow];
+      chunks[chunkIndex].ids()[row] = movedId;
+    }
+    if (--chunks[lastChunk].count == 0) {
+      free(chunks[lastChunk].data);
+      chunks.pop_back();
+    }
+    return movedId;
+  }
+
+  void* Archetype::at(uint32_t compIndex, uint32_t chunkIndex, uint32_t row) {
+    return chunks[chunkIndex].data + columnOffsets[compIndex] + getCompTypeInfo(compIndex).size * row;
+  }
+
+  ArchetypeStorage::ArchetypeStorage() { }
+
+  ArchetypeStorage::~ArchetypeStorage() {
+    for (auto archetype : archetypeList) {
+      delete archetype;
+    }
+  }
+
+  Archetype* ArchetypeStorage::findOrCreateArchetype(const compMask& mask) {
+    auto found = archetypes.find(mask);
+    if (found != archetypes.end()) {
+      return found->second;
+    }
+    Archetype* archetype = new Archetype(mask);
+    archetypes.emplace(mask, archetype);
+    archetypeList.push_back(archetype);
+    return archetype;
+  }
+
+  ArchetypeStorage::Location* ArchetypeStorage::locate(const entityId& id) {
+    if (idAllocator.isAlive(id)) {
+      return &locations[entityIndex(id)];
+    }
+    return nullptr;
+  }
+
+  void* ArchetypeStorage::move(const entityId& id, const compMask& newMask, uint32_t newCompIndex) {
+    Location& location = locations[entityIndex(id)];
+    Archetype* from = location.archetype;
+    Archetype* to = findOrCreateArchetype(newMask);
+    uint32_t toChunk, toRow = to->pushRow(id, &toChunk);
+    FOR_EACH_COLUMN(i, from->mask) {
+      void* src = from->at(i, location.chunk, location.row);
+      if (newMask.test(i)) {
+        getCompTypeInfo(i).moveConstruct(to->at(i, toChunk, toRow), src);
+      }
+      getCompTypeInfo(i).destroy(src);
+    }
+    entityId movedId = from->popRow(location.chunk, location.row);
+    if (movedId) {
+      locations[entityIndex(movedId)].chunk = location.chunk;
+      locations[entityIndex(movedId)].row = location.row;
+    }
+    location.archetype = to;
+    location.chunk = toChunk;
+    location.row = toRow;
+    return newCompIndex < numCompTypes ? to->at(newCompIndex, toChunk, toRow) : nullptr;
+  }
+
+  CompOpReturn ArchetypeStorage::createEntity(entityId* newId) {
+    entityId id;
+    if (!idAllocator.create(&id)) {
+      *newId = 0;
+      return MAX_ID_REACHED;
+    }
+    if (idAllocator.indexBound() > locations.size()) {
+      locations.resize(idAllocator.indexBound());
+    }
+    Archetype* archetype = findOrCreateArchetype(Existence::flag);
+    Location& location = locations[entityIndex(id)];
+    location.archetype = archetype;
+    location.row = archetype->pushRow(id, &location.chunk);
+    *newId = id;
+    return SUCCESS;
+  }
+
+  CompOpReturn ArchetypeStorage::deleteEntity(const entityId& id) {
+    Location* location = locate(id);
+    if (!location) {
+      return NONEXISTENT_ENT;
+    }
+    Archetype* archetype = location->archetype;
+    FOR_EACH_COLUMN(i, archetype->mask) {
+      getCompTypeInfo(i).destroy(archetype->at(i, location->chunk, location->row));
+    }
+    entityId movedId = archetype->popRow(location->chunk, location->row);
+    if (movedId) {
+      locations[entityIndex(movedId)].chunk = location->chunk;
+      locations[entityIndex(movedId)].row = location->row;
+    }
+    location->archetype = nullptr;
+    idAllocator.release(id);
+    return SUCCESS;
+  }
+
+  compMask ArchetypeStorage::getMask(const entityId& id) {
+    Location* location = locate(id);
+    return location ? location->archetype->mask : NONE;
+  }
+
+  #undef FOR_EACH_COLUMN
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_ARCHETYPES_H
+#define ECS_ARCHETYPES_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "ecsState.h"
+
+/*
+ * Size in bytes of a single chunk of archetype storage.
+ */
+#define ECS_ARCHETYPE_CHUNK_SIZE (16 * 1024)
+
+namespace ecs {
+
+  class Archetype;
+
+  /**
+   * Index of the single bit that is turned on in a component flag (ENUM_[component_type])
+   */
+  inline uint32_t flagIndex(const compMask& flag) {
+    return flag.lowestBit();
+  }
+
+  /**
+   * What the archetype storage needs to know about a component type in order to move it between chunks without
+   * knowing the type at compile time. One of these exists for each component type, indexed by flagIndex.
+   */
+  struct CompTypeInfo {
+    size_t size, align;
+    void (*moveConstruct)(void* dst, void* src);
+    void (*destroy)(void* comp);
+  };
+  const CompTypeInfo& getCompTypeInfo(uint32_t compIndex);
+
+  /**
+   * A fixed-size block of memory holding the components of up to 'capacity' entities of a single archetype.
+   * Components are stored as one packed array (column) per component type, so a system looking at one type of
+   * component walks straight through memory.
+   */
+  struct ArchetypeChunk {
+    unsigned char* data;
+    uint32_t count;
+    const Archetype* archetype;
+    inline entityId* ids() { return reinterpret_cast<entityId*>(data); }
+    template<typename compType>
+    compType* column();
+  };
+
+  /**
+   * An archetype holds all of the entities that have exactly the same set of components (mask).
+   */
+  class Archetype {
+      friend class ArchetypeStorage;
+      friend struct ArchetypeChunk;
+      compMask mask;
+      uint32_t capacity;
+      uint32_t columnOffsets[CompMask::numBits];
+      std::vector<ArchetypeChunk> chunks;
+      Archetype(const compMask& mask);
+      ~Archetype();
+      uint32_t pushRow(const entityId& id, uint32_t* chunkIndex);
+      entityId popRow(uint32_t chunkIndex, uint32_t row);
+      void* at(uint32_t compIndex, uint32_t chunkIndex, uint32_t row);
+    public:
+      const compMask& getMask() const { return mask; }
+      uint32_t getCapacity() const { return capacity; }
+  };
+
+  template<typename compType>
+  compType* ArchetypeChunk::column() {
+    static_assert(!std::is_same<compType, Existence>::value, "Existence has no column; use getMask instead");
+    return reinterpret_cast<compType*>(data + archetype->columnOffsets[compType::index]);
+  }
+
+  /**
+   * ArchetypeStorage - an alternative to the per-type component pools in State.
+   * Entities that share the same component mask (the same Existence::componentsPresent value) live together in
+   * fixed-size chunks of structure-of-arrays storage. Adding or removing a component moves the entity (and all of its
+   * components) to the archetype for its new mask. Queries on several components at once, like
+   * ENUM_Physics | ENUM_WasdControls, then walk the matching chunks directly instead of looking up every component of
+   * every entity individually.
+   *
+   * The interface mirrors the one State generates for each component, and follows the same prerequisite and
+   * dependency rules. Existence gets no column of its own, since an entity's archetype already is its mask, so it can't
+   * be passed to add(), rem(), get() or column().
+   * Pointers obtained with get() or a chunk's column() are good until the next structural change to the storage.
+   */
+  class ArchetypeStorage {
+      struct Location {
+        Archetype* archetype;
+        uint32_t chunk, row;
+      };
+      std::unordered_map<compMask, Archetype*> archetypes;
+      std::vector<Archetype*> archetypeList;
+      // Indexed by entity index. The allocator's generation check is what rejects stale ids.
+      std::vector<Location> locations;
+      EntityIdAllocator idAllocator;
+
+      Archetype* findOrCreateArchetype(const compMask& mask);
+      Location* locate(const entityId& id);
+      void* move(const entityId& id, const compMask& newMask, uint32_t newCompIndex);
+
+    public:
+      ArchetypeStorage();
+      ~ArchetypeStorage();
+
+      CompOpReturn createEntity(entityId* newId);
+      CompOpReturn deleteEntity(const entityId& id);
+      template<typename compType, typename ... types>
+      CompOpReturn add(const entityId& id, const types &... args);
+      template<typename compType>
+      CompOpReturn rem(const entityId& id);
+      template<typename compType>
+      CompOpReturn get(const entityId& id, compType** out);
+      compMask getMask(const entityId& id);
+
+      /**
+       * Calls 'fn(ArchetypeChunk&)' once for every non-empty chunk of every archetype that has at least the components
+       * described by 'likeness'.
+       */
+      template<typename Fn>
+      void forEachChunk(const compMask& likeness, Fn fn);
+
+      size_t numArchetypes() const { return archetypeList.size(); }
+  };
+
+  template<typename compType, typename ... types>
+  CompOpReturn ArchetypeStorage::add(const entityId& id, const types &... args) {
+    static_assert(!std::is_same<compType, Existence>::value, "Existence has no column; use getMask instead");
+    Location* location = locate(id);
+    if (!location) {
+      return NONEXISTENT_ENT;
+    }
+    compMask present = location->archetype->mask;
+    if (!present.contains(compType::requiredComps())) {
+      return PREREQ_FAIL;
+    }
+    if (present.intersects(compType::flag)) {
+      return REDUNDANT;
+    }
+    void* slot = move(id, present | compType::flag, compType::index);
+    new (slot) compType(args...);
+    return SUCCESS;
+  }
+
+  template<typename compType>
+  CompOpReturn ArchetypeStorage::rem(const entityId& id) {
+    static_assert(!std::is_same<compType, Existence>::value, "Existence has no column; use getMask instead");
+    Location* location = locate(id);
+    if (!location) {
+      return NONEXISTENT_ENT;
+    }
+    compMask present = location->archetype->mask;
+    if (!present.intersects(compType::flag)) {
+      return NONEXISTENT_COMP;
+    }
+    if (present.intersects(compType::dependentComps())) {
+      return DEPEND_FAIL;
+    }
+    move(id, present & ~compType::flag, CompMask::numBits);
+    return SUCCESS;
+  }
+
+  template<typename compType>
+  CompOpReturn ArchetypeStorage::get(const entityId& id, compType** out) {
+    static_assert(!std::is_same<compType, Existence>::value, "Existence has no column; use getMask instead");
+    Location* location = locate(id);
+    if (!location || !location->archetype->mask.intersects(compType::flag)) {
+      return NONEXISTENT_COMP;
+    }
+    *out = reinterpret_cast<compType*>(
+        location->archetype->at(compType::index, location->chunk, location->row));
+    return SUCCESS;
+  }
+
+  template<typename Fn>
+  void ArchetypeStorage::forEachChunk(const compMask& likeness, Fn fn) {
+    for (auto archetype : archetypeList) {
+      if (archetype->mask.contains(likeness)) {
+        for (auto& chunk : archetype->chunks) {
+          if (chunk.count) {
+            fn(chunk);
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif //ECS_ARCHETYPES_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_BINARY_FILE_H
+#define ECS_BINARY_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace ecs {
+
+  /*
+   * Helpers shared by the binary file formats (hull files, physics snapshots). Values are put together byte by byte,
+   * so files are the same whatever the host's byte order.
+   */
+  namespace binaryFile {
+    inline uint32_t decodeU32(const uint8_t* bytes) {
+      return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+    }
+    inline void encodeU32(uint32_t value, uint8_t* bytes) {
+      bytes[0] = (uint8_t) value;
+      bytes[1] = (uint8_t) (value >> 8);
+      bytes[2] = (uint8_t) (value >> 16);
+      bytes[3] = (uint8_t) (value >> 24);
+    }
+    inline bool readU32(FILE* file, uint32_t* out) {
+      uint8_t bytes[4];
+      if (fread(bytes, 1, 4, file) != 4) {
+        return false;
+      }
+      *out = decodeU32(bytes);
+      return true;
+    }
+    inline bool readFloat(FILE* file, float* out) {
+      uint32_t bits;
+      if (!readU32(file, &bits)) {
+        return false;
+      }
+      memcpy(out, &bits, sizeof(*out));
+      return true;
+    }
+    inline bool writeU32(FILE* file, uint32_t value) {
+      uint8_t bytes[4];
+      encodeU32(value, bytes);
+      return fwrite(bytes, 1, 4, file) == 4;
+    }
+    inline bool writeFloat(FILE* file, float value) {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return writeU32(file, bits);
+    }
+    inline bool readMagic(FILE* file, const char (&magic)[4]) {
+      char read[4];
+      return fread(read, 1, 4, file) == 4 && memcmp(read, magic, 4) == 0;
+    }
+    inline bool writeMagic(FILE* file, const char (&magic)[4]) {
+      return fwrite(magic, 1, 4, file) == 4;
+    }
+
+    /*
+     * Keeps track of how many bytes are left in a file being read, so that every count read from it can be checked
+     * against that before anything is allocated for it. The arithmetic is done in 64 bits, so no count can overflow it.
+     */
+    class ByteBudget {
+        uint64_t remaining;
+      public:
+        // Measures the whole of 'file', and leaves it at its beginning
+        explicit ByteBudget(FILE* file) {
+          fseek(file, 0, SEEK_END);
+          long size = ftell(file);
+          fseek(file, 0, SEEK_SET);
+          remaining = size > 0 ? (uint64_t) size : 0;
+        }
+        // Whether 'count' items of 'size' bytes each are left
+        bool has(uint64_t count, uint64_t size = 1) const {
+          return !size || count <= remaining / size;
+        }
+        // Takes 'count' items of 'size' bytes each from what's left, or returns false (taking nothing) if they aren't
+        bool take(uint64_t count, uint64_t size = 1) {
+          if (!has(count, size)) {
+            return false;
+          }
+          remaining -= count * size;
+          return true;
+        }
+    };
+  }
+}
+
+#endif //ECS_BINARY_FILE_H
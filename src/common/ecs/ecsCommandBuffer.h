@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_COMMAND_BUFFER_H
+#define ECS_COMMAND_BUFFER_H
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ecsState.h"
+
+namespace ecs {
+
+  /**
+   * CommandBuffer - records structural changes to a State (component additions and removals, entity deletion) so that
+   * they can be made later, all at once, at a point where no system is iterating over its registries.
+   *
+   * Entity creation happens immediately, since it only hands out an ID and fires no delegates. That also means it
+   * touches the State directly, so like BasicState::createEntity it must only be called from the main thread, never
+   * from inside a system's tick or parallelFor. Everything else is queued per component type and applied by flush(),
+   * which goes in this order:
+   *   1. additions, one component type at a time, in the order the types are listed in AllComps
+   *      (so prerequisites are added before the components that require them),
+   *   2. removals, one component type at a time, in reverse order (so dependents go first),
+   *   3. entity deletions.
+   * Within each step, each interested delegate is fired once per qualifying entity in one pass over the batch.
+   * Since the order in which commands were recorded is not kept, an entity that has both an addition and a removal
+   * of the same component type queued is a conflict: neither command is applied, and flush() reports CONFLICTING_CMDS.
+   *
+   * The methods for each component mirror the ones on BasicState (examples for imaginary 'FakeComponent'):
+   *   void add<FakeComponent>(entityId id, [applicable constructor arguments]);
+   *   void add<FakeComponent>(entityId id, const FakeComponent& copyThis);
+   *   void rem<FakeComponent>(entityId id);
+   * Nothing is checked when a command is recorded; the results of the checks are reported by flush().
+   */
+  template<typename ... comps>
+  class BasicCommandBuffer {
+    public:
+      template<typename compType, typename ... types>
+      void add(const entityId& id, const types &... args) {
+        std::get<CompIndex<compType, comps...>::value>(adds).push_back(std::make_pair(id, compType(args...)));
+      }
+      template<typename compType>
+      void rem(const entityId& id) {
+        rems[CompIndex<compType, comps...>::value].push_back(id);
+      }
+
+      /**
+       * Creates a new entity right away (see BasicState::createEntity). Main thread only.
+       */
+      CompOpReturn createEntity(BasicState<comps...>& state, entityId* newId) {
+        return state.createEntity(newId);
+      }
+
+      /**
+       * Queues the deletion of an entity. Deletions are made after all additions and removals.
+       */
+      void deleteEntity(const entityId& id) {
+        deletions.push_back(id);
+      }
+
+      /**
+       * Applies every queued command to 'state' and empties the buffer.
+       * @return SUCCESS, or the first failure encountered (see the CompOpReturn values of State's add, rem and delete
+       *         methods). A failed command does not stop the rest from being applied.
+       */
+      CompOpReturn flush(BasicState<comps...>& state);
+
+      /**
+       * Drops every queued command without applying it
+       */
+      void clear();
+
+      bool empty() const;
+
+    private:
+      std::tuple<std::vector<std::pair<entityId, comps>>...> adds;
+      std::vector<entityId> rems[sizeof...(comps)];
+      std::vector<entityId> deletions;
+
+      template<typename compType>
+      void dropConflicts(CompOpReturn& status);
+      template<typename compType>
+      void flushAdds(BasicState<comps...>& state, CompOpReturn& status);
+      template<typename compType>
+      void flushRems(BasicState<comps...>& state, CompOpReturn& status);
+      static inline void keepFirstFailure(CompOpReturn& status, CompOpReturn result) {
+        if (status == SUCCESS) {
+          status = result;
+        }
+      }
+  };
+
+  typedef ApplyComps<BasicCommandBuffer, AllComps>::type CommandBuffer;
+
+  template<typename ... comps>
+  CompOpReturn BasicCommandBuffer<comps...>::flush(BasicState<comps...>& state) {
+    typedef void (BasicCommandBuffer::*Flusher)(BasicState<comps...>&, CompOpReturn&);
+    static const Flusher remFlushers[] = { &BasicCommandBuffer::flushRems<comps>... };
+    CompOpReturn status = SUCCESS;
+    int expand[] = { 0, (dropConflicts<comps>(status), flushAdds<comps>(state, status), 0)... };
+    (void) expand;
+    for (uint32_t i = sizeof...(comps); i-- > 0; ) {
+      (this->*remFlushers[i])(state, status);
+    }
+    if (!deletions.empty()) {
+      keepFirstFailure(status, state.deleteEntities(deletions));
+      deletions.clear();
+    }
+    return status;
+  }
+
+  template<typename ... comps>
+  void BasicCommandBuffer<comps...>::clear() {
+    int expand[] = { 0, (std::get<CompIndex<comps, comps...>::value>(adds).clear(), 0)... };
+    (void) expand;
+    for (auto& queue : rems) {
+      queue.clear();
+    }
+    deletions.clear();
+  }
+
+  template<typename ... comps>
+  bool BasicCommandBuffer<comps...>::empty() const {
+    for (auto& queue : rems) {
+      if (!queue.empty()) {
+        return false;
+      }
+    }
+    return deletions.empty() && allOf(std::get<CompIndex<comps, comps...>::value>(adds).empty()...);
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicCommandBuffer<comps...>::dropConflicts(CompOpReturn& status) {
+    auto& added = std::get<CompIndex<compType, comps...>::value>(adds);
+    auto& removed = rems[CompIndex<compType, comps...>::value];
+    if (added.empty() || removed.empty()) {
+      return;
+    }
+    std::vector<entityId> addedIds;
+    addedIds.reserve(added.size());
+    for (auto& command : added) {
+      addedIds.push_back(command.first);
+    }
+    std::sort(addedIds.begin(), addedIds.end());
+    std::vector<entityId> conflicts;
+    for (auto& id : removed) {
+      if (std::binary_search(addedIds.begin(), addedIds.end(), id)) {
+        conflicts.push_back(id);
+      }
+    }
+    if (conflicts.empty()) {
+      return;
+    }
+    std::sort(conflicts.begin(), conflicts.end());
+    auto conflicting = [&conflicts](const entityId& id) {
+      return std::binary_search(conflicts.begin(), conflicts.end(), id);
+    };
+    typedef std::pair<entityId, compType> AddCommand;
+    added.erase(std::remove_if(added.begin(), added.end(), [&conflicting](const AddCommand& command) {
+      return conflicting(command.first);
+    }), added.end());
+    removed.erase(std::remove_if(removed.begin(), removed.end(), conflicting), removed.end());
+    keepFirstFailure(status, CONFLICTING_CMDS);
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicCommandBuffer<comps...>::flushAdds(BasicState<comps...>& state, CompOpReturn& status) {
+    auto& queue = std::get<CompIndex<compType, comps...>::value>(adds);
+    if (!queue.empty()) {
+      keepFirstFailure(status, state.template addBatch<compType>(queue));
+      queue.clear();
+    }
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicCommandBuffer<comps...>::flushRems(BasicState<comps...>& state, CompOpReturn& status) {
+    auto& queue = rems[CompIndex<compType, comps...>::value];
+    if (!queue.empty()) {
+      keepFirstFailure(status, state.template remBatch<compType>(queue));
+      queue.clear();
+    }
+  }
+}
+
+#endif //ECS_COMMAND_BUFFER_H
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Component masks (a.k.a. component signatures) - one bit per component type, 128 of them.
+ * Everything needed to build masks (bit, |, &, ~) is constexpr, so the ENUM_[component_type] flags and combinations
+ * of them like ENUM_Physics | ENUM_WasdControls are compile-time constants.
+ * The tests that run whenever components are added or removed (contains, intersects, ==) are done on the whole mask
+ * at once with SSE2 where it is available, and fall back to plain 64-bit operations elsewhere (Emscripten).
+ */
+
+#ifndef ECS_COMP_MASK_H
+#define ECS_COMP_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ECS_COMP_MASK_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+namespace ecs {
+
+  struct CompMask {
+    uint64_t lo, hi;
+
+    static const uint32_t numBits = 128;
+
+    constexpr CompMask() : lo(0), hi(0) { }
+    constexpr CompMask(uint64_t lo, uint64_t hi) : lo(lo), hi(hi) { }
+
+    /**
+     * @return a mask with only bit 'index' turned on
+     */
+    static constexpr CompMask bit(uint32_t index) {
+      return index < 64 ? CompMask(1ull << index, 0) : CompMask(0, 1ull << (index - 64));
+    }
+
+    constexpr CompMask operator | (const CompMask& other) const { return CompMask(lo | other.lo, hi | other.hi); }
+    constexpr CompMask operator & (const CompMask& other) const { return CompMask(lo & other.lo, hi & other.hi); }
+    constexpr CompMask operator ~ () const { return CompMask(~lo, ~hi); }
+    /*
+     * Compile-time versions of contains and intersects (see below), for use in static_asserts and constexpr functions.
+     */
+    constexpr bool hasAll(const CompMask& subset) const { return ((subset.lo & ~lo) | (subset.hi & ~hi)) == 0; }
+    constexpr bool hasAny(const CompMask& other) const { return ((lo & other.lo) | (hi & other.hi)) != 0; }
+
+    CompMask& operator |= (const CompMask& other) { lo |= other.lo; hi |= other.hi; return *this; }
+    CompMask& operator &= (const CompMask& other) { lo &= other.lo; hi &= other.hi; return *this; }
+
+    inline bool operator == (const CompMask& other) const;
+    inline bool operator != (const CompMask& other) const { return !(*this == other); }
+    inline bool any() const;
+    explicit operator bool() const { return any(); }
+
+    /**
+     * @return true if every bit turned on in 'subset' is also turned on in this mask
+     */
+    inline bool contains(const CompMask& subset) const;
+    /**
+     * @return true if any bit is turned on in both this mask and 'other'
+     */
+    inline bool intersects(const CompMask& other) const;
+
+    bool test(uint32_t index) const { return index < 64 ? (lo >> index) & 1 : (hi >> (index - 64)) & 1; }
+    /**
+     * @return the index of the lowest bit turned on, or numBits if none are
+     */
+    inline uint32_t lowestBit() const;
+  };
+
+  #ifdef ECS_COMP_MASK_SSE2
+  static inline __m128i loadMask(const CompMask& mask) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&mask));
+  }
+  static inline bool isZero(__m128i v) {
+    #ifdef __SSE4_1__
+    return _mm_testz_si128(v, v) != 0;
+    #else
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xffff;
+    #endif
+  }
+  bool CompMask::operator == (const CompMask& other) const {
+    return isZero(_mm_xor_si128(loadMask(*this), loadMask(other)));
+  }
+  bool CompMask::any() const {
+    return !isZero(loadMask(*this));
+  }
+  bool CompMask::contains(const CompMask& subset) const {
+    return isZero(_mm_andnot_si128(loadMask(*this), loadMask(subset))); // bits in subset but not in this
+  }
+  bool CompMask::intersects(const CompMask& other) const {
+    return !isZero(_mm_and_si128(loadMask(*this), loadMask(other)));
+  }
+  #else
+  bool CompMask::operator == (const CompMask& other) const {
+    return ((lo ^ other.lo) | (hi ^ other.hi)) == 0;
+  }
+  bool CompMask::any() const {
+    return (lo | hi) != 0;
+  }
+  bool CompMask::contains(const CompMask& subset) const {
+    return ((subset.lo & ~lo) | (subset.hi & ~hi)) == 0;
+  }
+  bool CompMask::intersects(const CompMask& other) const {
+    return ((lo & other.lo) | (hi & other.hi)) != 0;
+  }
+  #endif
+
+  uint32_t CompMask::lowestBit() const {
+    #if defined(__GNUC__)
+    return lo ? (uint32_t) __builtin_ctzll(lo) : hi ? 64 + (uint32_t) __builtin_ctzll(hi) : numBits;
+    #else
+    for (uint32_t index = 0; index < numBits; ++index) {
+      if (test(index)) {
+        return index;
+      }
+    }
+    return numBits;
+    #endif
+  }
+}
+
+namespace std {
+  template<>
+  struct hash<ecs::CompMask> {
+    size_t operator()(const ecs::CompMask& mask) const {
+      uint64_t h = mask.lo * 0x9e3779b97f4a7c15ull ^ (mask.hi + 0x7f4a7c159e3779b9ull + (mask.lo << 6));
+      return (size_t) (h ^ (h >> 32));
+    }
+  };
+}
+
+#endif //ECS_COMP_MASK_H
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Sparse set used to store components of a single type.
+ * Components live packed together in a dense array (in no particular order), and a sparse table indexed by entity
+ * index (see ecsEntityId.h) maps each entity to its component's slot in the dense array. The full ID is kept next to
+ * each component, so a stale ID whose index has since been reused fails lookup just like a missing one. Lookups are a
+ * bounds check and a few array reads, removal swaps the last component into the vacated slot, and iterating the pool
+ * walks contiguous memory.
+ *
+ * NOTE: Because components are moved around on removal (and on growth), pointers to components are only good until
+ * the next time a component of the same type is added or removed.
+ *
+ * Each component also carries a version: the tick (see BasicState::advanceTick) in which it was last marked as changed.
+ * The newest version in every run of versionBlockSize dense slots is kept as well, so finding the components changed
+ * since some tick only looks inside the runs that have any, and costs little more than the number of changes.
+ * Versions of different components may be marked from different threads at once.
+ */
+
+#ifndef ECS_COMP_POOL_H
+#define ECS_COMP_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+#include "ecsEntityId.h"
+
+namespace ecs {
+
+  template<class K, class V>
+  class CompPool {
+    private:
+      static const uint32_t npos = 0xffffffff;
+      static const uint32_t versionBlockSize = 64;
+      std::vector<uint32_t> sparse;
+      std::vector<K> denseKeys;
+      std::vector<V> dense;
+      std::vector<uint32_t> versions;
+      std::deque<std::atomic<uint32_t>> blockVersions; // a deque, since atomics can't be moved when a vector grows
+      void raiseBlockVersion(uint32_t slot, uint32_t version);
+
+    public:
+      CompPool();
+      ~CompPool();
+      V& at(const K& key);
+      V* find(const K& key);
+      void clear() noexcept;
+      bool contains(const K& key) const;
+      template<class... Args>
+      bool emplace(const K& key, Args&&... args);
+      bool erase(const K& key);
+      void reserve(std::size_t n);
+      size_t count(const K& key) const;
+      size_t size() const;
+      const K* keys() const;
+      V* data();
+      /**
+       * Sets the version of the component at 'key' (which must exist) to 'version'.
+       * Versions must only ever be raised, which holds as long as 'version' is always the current tick.
+       */
+      void markChanged(const K& key, uint32_t version);
+      /**
+       * @return the version of the component at 'key', or 0 if there is none
+       */
+      uint32_t version(const K& key) const;
+      /**
+       * Calls 'fn(const K&, V&)' for each component whose version is greater than 'since'
+       */
+      template<class Fn>
+      void forEachChangedSince(uint32_t since, Fn fn);
+      typedef typename std::vector<V>::iterator iterator;
+      typedef typename std::vector<V>::const_iterator const_iterator;
+      iterator begin() { return dense.begin(); }
+      iterator end() { return dense.end(); }
+      const_iterator begin() const { return dense.begin(); }
+      const_iterator end() const { return dense.end(); }
+  };
+
+  template<class K, class V>
+  const uint32_t CompPool<K, V>::npos;
+  template<class K, class V>
+  const uint32_t CompPool<K, V>::versionBlockSize;
+  template<class K, class V>
+  CompPool<K, V>::CompPool() { }
+  template<class K, class V>
+  CompPool<K, V>::~CompPool() { }
+  template<class K, class V>
+  V& CompPool<K, V>::at(const K& key) {
+    assert(contains(key));
+    return dense[sparse[entityIndex(key)]];
+  }
+  template<class K, class V>
+  V* CompPool<K, V>::find(const K& key) {
+    uint32_t index = entityIndex(key);
+    if (index < sparse.size() && sparse[index] != npos && denseKeys[sparse[index]] == key) {
+      return &dense[sparse[index]];
+    }
+    return nullptr;
+  }
+  template<class K, class V>
+  void CompPool<K, V>::clear() noexcept {
+    sparse.clear();
+    denseKeys.clear();
+    dense.clear();
+    versions.clear();
+    blockVersions.clear();
+  }
+  template<class K, class V>
+  bool CompPool<K, V>::contains(const K& key) const {
+    uint32_t index = entityIndex(key);
+    return index < sparse.size() && sparse[index] != npos && denseKeys[sparse[index]] == key;
+  }
+  template<class K, class V>
+  template<class... Args>
+  bool CompPool<K, V>::emplace(const K& key, Args&&... args) {
+    uint32_t index = entityIndex(key);
+    if (index >= sparse.size()) {
+      sparse.resize(index + 1, npos);
+    }
+    if (sparse[index] != npos) { // already present (components must be erased before their entity's index is reused)
+      assert(denseKeys[sparse[index]] == key);
+      return false;
+    }
+    sparse[index] = (uint32_t) dense.size();
+    denseKeys.push_back(key);
+    dense.emplace_back(std::forward<Args>(args)...);
+    versions.push_back(0);
+    if (dense.size() > blockVersions.size() * versionBlockSize) {
+      blockVersions.emplace_back(0u);
+    }
+    return true;
+  }
+  template<class K, class V>
+  bool CompPool<K, V>::erase(const K& key) {
+    if (!contains(key)) {
+      return false;
+    }
+    uint32_t slot = sparse[entityIndex(key)];
+    uint32_t last = (uint32_t) dense.size() - 1;
+    if (slot != last) { // move the last component into the hole left by the erased one
+      dense[slot] = std::move(dense[last]);
+      denseKeys[slot] = denseKeys[last];
+      versions[slot] = versions[last];
+      raiseBlockVersion(slot, versions[slot]);
+      sparse[entityIndex(denseKeys[slot])] = slot;
+    }
+    dense.pop_back();
+    denseKeys.pop_back();
+    versions.pop_back();
+    if (blockVersions.size() * versionBlockSize >= dense.size() + versionBlockSize) {
+      blockVersions.pop_back();
+    }
+    sparse[entityIndex(key)] = npos;
+    return true;
+  }
+  template<class K, class V>
+  void CompPool<K, V>::reserve(std::size_t n) {
+    sparse.reserve(n);
+    denseKeys.reserve(n);
+    dense.reserve(n);
+    versions.reserve(n);
+  }
+  template<class K, class V>
+  size_t CompPool<K, V>::count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+  template<class K, class V>
+  size_t CompPool<K, V>::size() const {
+    return dense.size();
+  }
+  template<class K, class V>
+  const K* CompPool<K, V>::keys() const {
+    return denseKeys.data();
+  }
+  template<class K, class V>
+  V* CompPool<K, V>::data() {
+    return dense.data();
+  }
+  template<class K, class V>
+  void CompPool<K, V>::raiseBlockVersion(uint32_t slot, uint32_t version) {
+    std::atomic<uint32_t>& block = blockVersions[slot / versionBlockSize];
+    if (block.load(std::memory_order_relaxed) < version) {
+      block.store(version, std::memory_order_relaxed);
+    }
+  }
+  template<class K, class V>
+  void CompPool<K, V>::markChanged(const K& key, uint32_t version) {
+    assert(contains(key));
+    uint32_t slot = sparse[entityIndex(key)];
+    versions[slot] = version;
+    // Every thread marking at the same time stores the same (current) tick, so there is no need to compare here.
+    blockVersions[slot / versionBlockSize].store(version, std::memory_order_relaxed);
+  }
+  template<class K, class V>
+  uint32_t CompPool<K, V>::version(const K& key) const {
+    return contains(key) ? versions[sparse[entityIndex(key)]] : 0;
+  }
+  template<class K, class V>
+  template<class Fn>
+  void CompPool<K, V>::forEachChangedSince(uint32_t since, Fn fn) {
+    uint32_t size = (uint32_t) dense.size();
+    for (uint32_t block = 0; block < (uint32_t) blockVersions.size(); ++block) {
+      if (blockVersions[block].load(std::memory_order_relaxed) <= since) {
+        continue;
+      }
+      uint32_t end = std::min(size, (block + 1) * versionBlockSize);
+      for (uint32_t slot = block * versionBlockSize; slot < end; ++slot) {
+        if (versions[slot] > since) {
+          fn(denseKeys[slot], dense[slot]);
+        }
+      }
+    }
+  }
+}
+
+#endif //ECS_COMP_POOL_H
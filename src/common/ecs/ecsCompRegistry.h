@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Compile-time component registry.
+ * The component types are listed once, as a CompList (see AllComps in ecsComponents.h). Everything that used to be
+ * stamped out per component type by preprocessor loops is instead derived from that list by the templates here:
+ * each type's index (and so its bit in a compMask), the masks of the components that depend on it, and the checks that
+ * the prerequisites declared by every component make sense, which are done by the compiler (see BasicState).
+ */
+
+#ifndef ECS_COMP_REGISTRY_H
+#define ECS_COMP_REGISTRY_H
+
+#include <cstdint>
+#include <type_traits>
+#include "ecsCompMask.h"
+
+namespace ecs {
+
+  /**
+   * An ordered list of component types. Holds no data, it only exists to be pattern matched against.
+   */
+  template<typename ... comps>
+  struct CompList {
+    static const uint32_t size = sizeof...(comps);
+  };
+
+  template<typename T>
+  struct AlwaysFalse : std::false_type { };
+
+  /**
+   * CompIndex<T, comps...>::value is the position of T in comps (a compile error if it isn't there).
+   */
+  template<typename T, typename ... comps>
+  struct CompIndex {
+    static_assert(AlwaysFalse<T>::value, "Component type is not registered");
+  };
+  template<typename T, typename ... rest>
+  struct CompIndex<T, T, rest...> : std::integral_constant<uint32_t, 0> { };
+  template<typename T, typename U, typename ... rest>
+  struct CompIndex<T, U, rest...> : std::integral_constant<uint32_t, 1 + CompIndex<T, rest...>::value> { };
+
+  /**
+   * Same as CompIndex, but takes the types as a CompList
+   */
+  template<typename T, typename list>
+  struct IndexInList;
+  template<typename T, typename ... comps>
+  struct IndexInList<T, CompList<comps...>> : CompIndex<T, comps...> { };
+
+  /**
+   * ApplyComps<Target, CompList<A, B, C>>::type is Target<A, B, C>
+   */
+  template<template<typename...> class Target, typename list>
+  struct ApplyComps;
+  template<template<typename...> class Target, typename ... comps>
+  struct ApplyComps<Target, CompList<comps...>> {
+    typedef Target<comps...> type;
+  };
+
+  constexpr bool allOf() { return true; }
+  template<typename ... rest>
+  constexpr bool allOf(bool first, rest... others) { return first && allOf(others...); }
+
+  /**
+   * @return the flags of every type in the list together
+   */
+  constexpr CompMask maskOf(CompList<>) { return CompMask(); }
+  template<typename T, typename ... rest>
+  constexpr CompMask maskOf(CompList<T, rest...>) { return T::flag | maskOf(CompList<rest...>()); }
+
+  /**
+   * @return the flags of every type in the list that lists T as one of its required components
+   */
+  template<typename T>
+  constexpr CompMask dependentsOf(CompList<>) { return CompMask(); }
+  template<typename T, typename U, typename ... rest>
+  constexpr CompMask dependentsOf(CompList<U, rest...>) {
+    return (U::requiredComps().hasAny(T::flag) ? U::flag : CompMask()) | dependentsOf<T>(CompList<rest...>());
+  }
+
+  /**
+   * @return true if, for every type U in the list that T requires, T also requires everything U does.
+   * If that holds for every component type, and none requires itself, then there can be no circular requirements.
+   */
+  template<typename T>
+  constexpr bool requirementsClosed(CompList<>) { return true; }
+  template<typename T, typename U, typename ... rest>
+  constexpr bool requirementsClosed(CompList<U, rest...>) {
+    return (!T::requiredComps().hasAny(U::flag) || T::requiredComps().hasAll(U::requiredComps()))
+           && requirementsClosed<T>(CompList<rest...>());
+  }
+}
+
+#endif //ECS_COMP_REGISTRY_H
@@ -25,61 +25,25 @@
 namespace ecs {
 
   /*
-   * The following macros describe the dependency relationships between components.The first block enumerates for
-   * a given component what other components are required for it to exist. For example, it makes no sense for an
-   * entity to posses linear velocity without first having a position. This relationship is important when you're
-   * adding new components to the world. Notice that all components list the existence component as a requirement.
-   *
-   * The second set of macros describe the inverse relationships, or for a given component, which other components
-   * list it as a required component. This relationship is examined upon the deletion of a component. Notice that
-   * the existence component is a lists 'ALL' (minus itself) as its dependents.
-   *
-   * TODO: Add GEN_COMP_DEFN_REQD and GEN_COMP_DEFN_DEPN entries below for any new component types you create.
-   * The generated format for any component enumerator is 'ENUM_[component_type].' As seen below, the ALL and NONE
-   * enumerators also exist. Since these are bit flags, you can probably guess that NONE is zero and ALL is
-   * unsigned -1, or in other words, ALL has all the bits turned on.
-   */
-  GEN_COMP_DEFN_REQD(Existence, NONE);
-  GEN_COMP_DEFN_REQD(Position, ENUM_Existence);
-  GEN_COMP_DEFN_REQD(Scale, ENUM_Existence);
-  GEN_COMP_DEFN_REQD(ScalarMultFunc, ENUM_Existence | ENUM_Scale);
-  GEN_COMP_DEFN_REQD(Orientation, ENUM_Existence);
-  GEN_COMP_DEFN_REQD(Perspective, ENUM_Existence | ENUM_Position | ENUM_Orientation);
-  GEN_COMP_DEFN_REQD(WasdControls, ENUM_Existence | ENUM_Orientation);
-  GEN_COMP_DEFN_REQD(MouseControls, ENUM_Existence | ENUM_Orientation);
-  GEN_COMP_DEFN_REQD(Physics, ENUM_Existence | ENUM_Position | ENUM_Orientation);
-
-  GEN_COMP_DEFN_DEPN(Existence, ALL & ~ENUM_Existence);
-  GEN_COMP_DEFN_DEPN(Position, ENUM_Perspective | ENUM_Physics);
-  GEN_COMP_DEFN_DEPN(Scale, ENUM_ScalarMultFunc);
-  GEN_COMP_DEFN_DEPN(ScalarMultFunc, NONE);
-  GEN_COMP_DEFN_DEPN(Orientation, ENUM_Perspective | ENUM_Physics | ENUM_MouseControls | ENUM_WasdControls);
-  GEN_COMP_DEFN_DEPN(Perspective, NONE);
-  GEN_COMP_DEFN_DEPN(WasdControls, NONE);
-  GEN_COMP_DEFN_DEPN(MouseControls, NONE);
-  GEN_COMP_DEFN_DEPN(Physics, NONE);
-
-  /*
-   * The following area is for the definitions of any component methods you create. Make sure that constructor
-   * parameters match the 'SIG_[component_type]' define you provided with the declaration of the component.
+   * The following area is for the definitions of any component methods you create.
    * TODO: Add any and all component member method definitions here.
    * NOTE: Generally there shouldn't be many methods except the constructor. Game logic ought to go in the systems..
    * Sometimes its convenient to put helper methods in some components, however (like the interpolating getters in
    * the Position and Orientation components), so those are probably ok.
    */
-  bool Existence::flagIsOn(int compType) {
-    return (compType & componentsPresent) != NONE;
+  bool Existence::flagIsOn(const compMask& compType) {
+    return componentsPresent.intersects(compType);
   }
-  bool Existence::passesPrerequisitesForAddition(compMask mask) {
-    return (mask & componentsPresent) == mask;
+  bool Existence::passesPrerequisitesForAddition(const compMask& mask) {
+    return componentsPresent.contains(mask);
   }
-  bool Existence::passesDependenciesForRemoval(compMask mask) {
-    return (mask & componentsPresent) == NONE;
+  bool Existence::passesDependenciesForRemoval(const compMask& mask) {
+    return !componentsPresent.intersects(mask);
   }
-  void Existence::turnOnFlags(compMask mask) {
+  void Existence::turnOnFlags(const compMask& mask) {
     componentsPresent |= mask;
   }
-  void Existence::turnOffFlags(compMask mask) {
+  void Existence::turnOffFlags(const compMask& mask) {
     componentsPresent &= ~mask;
   }
   Position::Position(glm::vec3 vec) : vec(vec), lastVec(vec) {}
@@ -96,12 +60,24 @@ namespace ecs {
       : fovy(fovy), prevFovy(fovy), near(near), far(far) {}
   WasdControls::WasdControls(entityId orientationProxy, Style style) : orientationProxy(orientationProxy), style(style) { }
   MouseControls::MouseControls(bool invertedX, bool invertedY) : invertedX(invertedX), invertedY(invertedY) { }
-  Physics::Physics(float mass, void* geomData, Geometry geom) : geom(geom), mass(mass), geomInitData(geomData) { }
+  Physics::Physics(float mass, void* geomData, Geometry geom)
+      : geom(geom), mass(mass), shape(nullptr), rigidBody(nullptr), geomInitData(geomData) { }
+  Trigger::Trigger(float radius) : radius(radius), shape(nullptr), ghost(nullptr) { }
 
-  /*
-   * This macro defines these function:
-   * compMask getRequiredComps(int compType);
-   * compMask getDependentComps(int compType);
-   */
-  GEN_COMP_DEFNS(ALL_COMPS);
+  template<typename ... comps>
+  static compMask requiredByIndex(uint32_t index, CompList<comps...>) {
+    static const compMask table[] = { comps::requiredComps()... };
+    return index < sizeof...(comps) ? table[index] : ALL;
+  }
+  template<typename ... comps>
+  static compMask dependentByIndex(uint32_t index, CompList<comps...>) {
+    static const compMask table[] = { comps::dependentComps()... };
+    return index < sizeof...(comps) ? table[index] : ALL;
+  }
+  compMask getRequiredComps(const compMask& compType) {
+    return requiredByIndex(compType.lowestBit(), AllComps());
+  }
+  compMask getDependentComps(const compMask& compType) {
+    return dependentByIndex(compType.lowestBit(), AllComps());
+  }
 }
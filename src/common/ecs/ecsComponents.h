@@ -23,71 +23,134 @@
 #ifndef ECS_COMPONENTS_H
 #define ECS_COMPONENTS_H
 
-#include "ecsAutoGen.h"
+#include "ecsCompMask.h"
+#include "ecsCompRegistry.h"
 #include "ecsDelegate.h"
+#include "ecsEntityId.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
 class btCollisionShape;
 class btDefaultMotionState;
+class btPairCachingGhostObject;
 class btRigidBody;
 
 namespace ecs {
 
-  typedef uint32_t compMask;
-  typedef uint32_t entityId;
+  typedef CompMask compMask;
 
+  /*
+   * The component registry: every component type, in order. A component's position in this list is its index, and
+   * the bit it is given in a compMask (ENUM_[component_type]).
+   * TODO: Forward declare any new component type here, add it to the end of AllComps, and declare it below.
+   */
+  struct Existence;
+  struct Position;
+  struct Scale;
+  struct ScalarMultFunc;
+  struct Orientation;
+  struct Perspective;
+  struct WasdControls;
+  struct MouseControls;
+  struct Physics;
+  struct Trigger;
+
+  typedef CompList<
+    Existence,
+    Position,
+    Scale,
+    ScalarMultFunc,
+    Orientation,
+    Perspective,
+    WasdControls,
+    MouseControls,
+    Physics,
+    Trigger
+  > AllComps;
+
+  const uint8_t numCompTypes = AllComps::size;
+  static_assert(AllComps::size <= CompMask::numBits, "Too many component types");
+
+  /*
+   * Every component type derives from Component<itself>, which gives it
+   *   index            - its position in AllComps
+   *   flag             - its bit (the same as ENUM_[component_type])
+   *   dependentComps() - the flags of every component type that lists it in its requiredComps()
+   * Every component type must in turn declare
+   *   static constexpr compMask requiredComps() - the components an entity must already have before it can be given
+   *                                               this one (all but Existence require at least ENUM_Existence)
+   */
   template <typename Derived>
   struct Component {
-    static compMask requiredComps;
-    static compMask dependentComps;
-    static compMask flag;
+    static constexpr uint32_t index = IndexInList<Derived, AllComps>::value;
+    static constexpr compMask flag = CompMask::bit(index);
+    static constexpr compMask dependentComps();
   };
+  template <typename Derived>
+  constexpr uint32_t Component<Derived>::index;
+  template <typename Derived>
+  constexpr compMask Component<Derived>::flag;
+
+  constexpr compMask NONE = CompMask();
+  constexpr compMask ALL = ~CompMask();
+  constexpr compMask ENUM_Existence = Component<Existence>::flag;
+  constexpr compMask ENUM_Position = Component<Position>::flag;
+  constexpr compMask ENUM_Scale = Component<Scale>::flag;
+  constexpr compMask ENUM_ScalarMultFunc = Component<ScalarMultFunc>::flag;
+  constexpr compMask ENUM_Orientation = Component<Orientation>::flag;
+  constexpr compMask ENUM_Perspective = Component<Perspective>::flag;
+  constexpr compMask ENUM_WasdControls = Component<WasdControls>::flag;
+  constexpr compMask ENUM_MouseControls = Component<MouseControls>::flag;
+  constexpr compMask ENUM_Physics = Component<Physics>::flag;
+  constexpr compMask ENUM_Trigger = Component<Trigger>::flag;
 
   /*
    * The following are component type declarations.
-   * TODO: Declare new components here and be sure to define 'SIG_[component_type]' as the constructor parameter types.
+   * TODO: Declare new components here, along with the components they require (see Component above).
    * NOTE: Just follow the examples of the others.
+   * The requirements are checked when the code is compiled: each must include ENUM_Existence (except Existence's own),
+   * may not include the component itself or an unregistered one, and must include the requirements of each component
+   * it requires (so ScalarMultFunc, which needs a Scale, would also have to list whatever Scale needs).
    */
-  #define SIG_Existence
   struct Existence : public Component<Existence> {
-    compMask componentsPresent = 0;
-    bool flagIsOn(int compType);
-    bool passesPrerequisitesForAddition(compMask mask);
-    bool passesDependenciesForRemoval(compMask mask);
-    void turnOnFlags(compMask mask);
-    void turnOffFlags(compMask mask);
+    static constexpr compMask requiredComps() { return NONE; }
+    compMask componentsPresent;
+    bool flagIsOn(const compMask& compType);
+    bool passesPrerequisitesForAddition(const compMask& mask);
+    bool passesDependenciesForRemoval(const compMask& mask);
+    void turnOnFlags(const compMask& mask);
+    void turnOffFlags(const compMask& mask);
   };
-  #define SIG_Position glm::vec3
   struct Position : public Component<Position> {
+    static constexpr compMask requiredComps() { return ENUM_Existence; }
     glm::vec3 vec, lastVec;
     Position(glm::vec3 vec);
     glm::vec3 getVec(float alpha);
   };
-  #define SIG_Scale glm::vec3
   struct Scale : public Component<Scale> {
+    static constexpr compMask requiredComps() { return ENUM_Existence; }
     glm::vec3 vec, lastVec;
     Scale(glm::vec3 vec);
   };
-  #define SIG_ScalarMultFunc Delegate<glm::vec3(const glm::vec3&, uint32_t time)>
   struct ScalarMultFunc : public Component<ScalarMultFunc> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Scale; }
     Delegate<glm::vec3(const glm::vec3&, uint32_t time)> multByFuncOfTime;
     ScalarMultFunc(Delegate<glm::vec3(const glm::vec3&, uint32_t time)> func);
   };
-  #define SIG_Orientation glm::quat
   struct Orientation : public Component<Orientation> {
+    static constexpr compMask requiredComps() { return ENUM_Existence; }
     glm::quat quat, lastQuat;
     Orientation(glm::quat quat);
     glm::quat getQuat(float alpha);
   };
-  #define SIG_Perspective float, float, float
   struct Perspective : public Component<Perspective> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Position | ENUM_Orientation; }
     float fovy, prevFovy,
           near, far;
     Perspective(float fovy, float near, float far);
   };
-  #define SIG_WasdControls entityId, WasdControls::Style
   struct WasdControls : public Component<WasdControls> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Orientation; }
     enum Style {
       ROTATE_ALL_AXES, ROTATE_ABOUT_Z
     };
@@ -96,15 +159,23 @@ namespace ecs {
     int style;
     WasdControls(entityId orientationProxy, Style style);
   };
-  #define SIG_MouseControls bool, bool
   struct MouseControls : public Component<MouseControls> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Orientation; }
     bool invertedX, invertedY;
     MouseControls(bool invertedX, bool invertedY);
   };
-  #define SIG_Physics float, void*, Physics::Geometry
   struct Physics : public Component<Physics> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Position | ENUM_Orientation; }
+    /*
+     * What geomInitData points to for each geometry:
+     *   SPHERE    - float, the radius
+     *   MESH      - std::vector<float>, the hull's points as x, y, z triples
+     *   HULL_FILE - const char, the path of a hull file baked by hullBaker (see ecsHullFile.h)
+     *   SNAPSHOT  - const SnapshotBody (see ecsPhysicsSnapshot.h), with the shape already set. Only made by
+     *               PhysicsSystem::loadSnapshot.
+     */
     enum Geometry {
-      NONE, PLANE, SPHERE, MESH
+      NONE, PLANE, SPHERE, MESH, HULL_FILE, SNAPSHOT
     };
     int geom;
     float mass;
@@ -113,54 +184,29 @@ namespace ecs {
     void* geomInitData;
     Physics(float mass, void* geomData, Geometry geom);
   };
-
   /*
-   * TODO: Add an entry to the end of each of the three directives below for any new component types you create.
-   * (follow examples of others)
+   * A sphere that reports what touches it (as contact events, see PhysicsSystem::getContactEvents) without pushing
+   * anything. Its ghost object keeps the list of everything overlapping its bounding box, for cheap broad checks.
    */
-  #define ALL_COMPS \
-    Existence,      \
-    Position,       \
-    Scale,          \
-    ScalarMultFunc, \
-    Orientation,    \
-    Perspective,    \
-    WasdControls,   \
-    MouseControls,  \
-    Physics
-
-  #define GEN_COLL_DECLS \
-    GEN_COMP_COLL_DECL(Existence)     \
-    GEN_COMP_COLL_DECL(Position)      \
-    GEN_COMP_COLL_DECL(Scale)         \
-    GEN_COMP_COLL_DECL(ScalarMultFunc)\
-    GEN_COMP_COLL_DECL(Orientation)   \
-    GEN_COMP_COLL_DECL(Perspective)   \
-    GEN_COMP_COLL_DECL(WasdControls)  \
-    GEN_COMP_COLL_DECL(MouseControls) \
-    GEN_COMP_COLL_DECL(Physics)
+  struct Trigger : public Component<Trigger> {
+    static constexpr compMask requiredComps() { return ENUM_Existence | ENUM_Position | ENUM_Orientation; }
+    float radius;
+    btCollisionShape* shape;
+    btPairCachingGhostObject* ghost;
+    Trigger(float radius);
+  };
 
-  #define GEN_COLL_DEFNS \
-    GEN_COMP_COLL_DEFN(Existence)     \
-    GEN_COMP_COLL_DEFN(Position)      \
-    GEN_COMP_COLL_DEFN(Scale)         \
-    GEN_COMP_COLL_DEFN(ScalarMultFunc)\
-    GEN_COMP_COLL_DEFN(Orientation)   \
-    GEN_COMP_COLL_DEFN(Perspective)   \
-    GEN_COMP_COLL_DEFN(WasdControls)  \
-    GEN_COMP_COLL_DEFN(MouseControls) \
-    GEN_COMP_COLL_DEFN(Physics)
+  template <typename Derived>
+  constexpr compMask Component<Derived>::dependentComps() {
+    return dependentsOf<Derived>(AllComps());
+  }
 
   /*
-   * This macro does the following:
-   * generates bit flag enumerations for all component types
-   * declares and defines uint8_t numCompTypes as the number of component types total
-   * declares these functions:
+   * The same masks as compType::requiredComps() and compType::dependentComps(), for when the component type is only
+   * known at run time (by its flag). Both return ALL for a flag that isn't a registered component.
    */
-  GEN_COMP_DECLS(ALL_COMPS)
-
-  compMask getRequiredComps(int compType);
-  compMask getDependentComps(int compType);
+  compMask getRequiredComps(const compMask& compType);
+  compMask getDependentComps(const compMask& compType);
 
 }
 
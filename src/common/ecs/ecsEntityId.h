@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Entity IDs are handles made of two parts: the low 24 bits are an index, which is what the component pools are
+ * indexed by, and the high 8 bits are a generation, which is bumped every time the entity at that index is deleted.
+ * A handle kept around after its entity was deleted (like a WasdControls::orientationProxy pointing at a deleted
+ * camera gimbal) then no longer matches the generation stored for its index, and is rejected as nonexistent instead of
+ * silently referring to whatever entity has since been given that index.
+ *
+ * Index 0 is never used, so an ID of 0 is never valid.
+ */
+
+#ifndef ECS_ENTITY_ID_H
+#define ECS_ENTITY_ID_H
+
+#include <cstdint>
+#include <stack>
+#include <vector>
+
+namespace ecs {
+
+  typedef uint32_t entityId;
+
+  const uint32_t entityIndexBits = 24;
+  const uint32_t entityIndexMask = (1u << entityIndexBits) - 1;
+  const uint32_t maxEntityGeneration = 0xff;
+
+  inline uint32_t entityIndex(const entityId& id) { return id & entityIndexMask; }
+  inline uint32_t entityGeneration(const entityId& id) { return id >> entityIndexBits; }
+  inline entityId makeEntityId(uint32_t index, uint32_t generation) {
+    return (generation << entityIndexBits) | (index & entityIndexMask);
+  }
+
+  /**
+   * Hands out entity IDs and keeps track of which generation of each index is currently alive.
+   * When an index has been through every generation it is retired instead of wrapping back around to generation 0,
+   * so that an old handle can never come back to life.
+   */
+  class EntityIdAllocator {
+      std::vector<uint8_t> generations; // current generation of each index ever handed out
+      std::vector<bool> alive;
+      std::stack<uint32_t> freedIndices;
+    public:
+      EntityIdAllocator() : generations(1, 0), alive(1, false) { } // index 0 is reserved
+
+      /**
+       * @return false if every index is in use or retired
+       */
+      bool create(entityId* newId) {
+        uint32_t index;
+        if (freedIndices.empty()) {
+          if (generations.size() > entityIndexMask) {
+            return false;
+          }
+          index = (uint32_t) generations.size();
+          generations.push_back(0);
+          alive.push_back(false);
+        } else {
+          index = freedIndices.top();
+          freedIndices.pop();
+        }
+        alive[index] = true;
+        *newId = makeEntityId(index, generations[index]);
+        return true;
+      }
+
+      /**
+       * @return false if the id is not (or no longer) a live entity
+       */
+      bool release(const entityId& id) {
+        if (!isAlive(id)) {
+          return false;
+        }
+        uint32_t index = entityIndex(id);
+        alive[index] = false;
+        if (generations[index] < maxEntityGeneration) {
+          ++generations[index];
+          freedIndices.push(index);
+        }
+        return true;
+      }
+
+      bool isAlive(const entityId& id) const {
+        uint32_t index = entityIndex(id);
+        return index < generations.size() && alive[index] && generations[index] == entityGeneration(id);
+      }
+
+      /**
+       * @return one past the highest index handed out so far
+       */
+      uint32_t indexBound() const { return (uint32_t) generations.size(); }
+  };
+}
+
+#endif //ECS_ENTITY_ID_H
@@ -33,6 +33,7 @@ namespace ecs {
       GEN_CASE(PREREQ_FAIL);
       GEN_CASE(DEPEND_FAIL);
       GEN_CASE(MAX_ID_REACHED);
+      GEN_CASE(CONFLICTING_CMDS);
       default:
         return "Unknown Error";
     }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include "ecsBinaryFile.h"
+#include "ecsHullFile.h"
+
+namespace ecs {
+  using namespace binaryFile;
+
+  static const char hullMagic[4] = { 'H', 'U', 'L', 'L' };
+
+  bool loadHullFile(const std::string& path, std::vector<HullPoints>* hulls) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+      fprintf(stderr, "Failed to open hull file '%s'\n", path.c_str());
+      return false;
+    }
+    ByteBudget budget(file);
+    uint32_t version, numHulls;
+    bool ok = readMagic(file, hullMagic) && readU32(file, &version) && version == HULL_FILE_VERSION
+              && readU32(file, &numHulls) && numHulls > 0 && budget.take(12);
+    hulls->clear();
+    for (uint32_t i = 0; ok && i < numHulls; ++i) {
+      uint32_t numPoints;
+      ok = readU32(file, &numPoints) && numPoints > 0 && budget.take(4) && budget.take(numPoints, 3 * sizeof(float));
+      if (!ok) {
+        break;
+      }
+      HullPoints points((size_t) numPoints * 3);
+      for (size_t coord = 0; ok && coord < points.size(); ++coord) {
+        ok = readFloat(file, &points[coord]);
+      }
+      hulls->push_back(std::move(points));
+    }
+    fclose(file);
+    if (!ok) {
+      fprintf(stderr, "'%s' is not a valid hull file\n", path.c_str());
+      hulls->clear();
+    }
+    return ok;
+  }
+
+  bool saveHullFile(const std::string& path, const std::vector<HullPoints>& hulls) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+      fprintf(stderr, "Failed to open hull file '%s' for writing\n", path.c_str());
+      return false;
+    }
+    bool ok = writeMagic(file, hullMagic)
+              && writeU32(file, HULL_FILE_VERSION)
+              && writeU32(file, (uint32_t) hulls.size());
+    for (auto& points : hulls) {
+      ok = ok && writeU32(file, (uint32_t) (points.size() / 3));
+      for (size_t i = 0; ok && i < points.size() / 3 * 3; ++i) {
+        ok = writeFloat(file, points[i]);
+      }
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+      fprintf(stderr, "Failed to write hull file '%s'\n", path.c_str());
+    }
+    return ok;
+  }
+}
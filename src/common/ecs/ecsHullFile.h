@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_HULL_FILE_H
+#define ECS_HULL_FILE_H
+
+#include <string>
+#include <vector>
+
+namespace ecs {
+
+  /*
+   * Hull files (.hull) hold one or more convex hulls, baked ahead of time from a mesh by the hullBaker tool (see
+   * src/tools/hullBaker), so that nothing needs to be computed when a Physics::HULL_FILE entity is created.
+   * One hull becomes a btConvexHullShape, and several become the children of a btCompoundShape.
+   *
+   * Layout, every value little-endian:
+   *   char[4]  "HULL"
+   *   uint32   format version (HULL_FILE_VERSION)
+   *   uint32   number of hulls
+   *   then for each hull:
+   *     uint32   number of points
+   *     float    x, y, z of each point
+   */
+  #define HULL_FILE_VERSION 1
+
+  typedef std::vector<float> HullPoints; // consecutive x, y, z triples
+
+  /**
+   * Reads every hull in the file at 'path' into 'hulls' (replacing whatever it held).
+   * @return false (with a message on stderr) if the file can't be read or isn't a valid hull file
+   */
+  bool loadHullFile(const std::string& path, std::vector<HullPoints>* hulls);
+  /**
+   * @return false (with a message on stderr) if the file can't be written
+   */
+  bool saveHullFile(const std::string& path, const std::vector<HullPoints>& hulls);
+}
+
+#endif //ECS_HULL_FILE_H
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include <cstring>
+#include "ecsBinaryFile.h"
+#include "ecsPhysicsSnapshot.h"
+
+namespace ecs {
+  using namespace binaryFile;
+
+  static const char snapshotMagic[4] = { 'S', 'N', 'A', 'P' };
+
+  static bool readShape(FILE* file, ByteBudget* budget, SnapshotShape* shape) {
+    if (!readU32(file, &shape->kind) || !budget->take(4)) {
+      return false;
+    }
+    uint32_t count;
+    switch (shape->kind) {
+      case SnapshotShape::SPHERE:
+        return readFloat(file, &shape->radius) && budget->take(4);
+      case SnapshotShape::HULL:
+        if (!readU32(file, &count) || count == 0 || !budget->take(4) || !budget->take(count, 3 * 4)) {
+          return false;
+        }
+        shape->points.resize((size_t) count * 3);
+        for (auto& coord : shape->points) {
+          if (!readFloat(file, &coord)) {
+            return false;
+          }
+        }
+        return true;
+      case SnapshotShape::HULL_FILE:
+        if (!readU32(file, &count) || count == 0 || !budget->take(4) || !budget->take(count)) {
+          return false;
+        }
+        shape->file.resize(count);
+        return fread(&shape->file[0], 1, count, file) == count;
+      default:
+        return false;
+    }
+  }
+
+  bool loadPhysicsSnapshot(const std::string& path, PhysicsSnapshot* snapshot) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+      fprintf(stderr, "Failed to open physics snapshot '%s'\n", path.c_str());
+      return false;
+    }
+    ByteBudget budget(file);
+    uint32_t version, numShapes, numBodies;
+    // Every shape takes at least 8 bytes (its kind and one value)
+    bool ok = readMagic(file, snapshotMagic) && readU32(file, &version) && version == PHYSICS_SNAPSHOT_VERSION
+              && readU32(file, &numShapes) && budget.take(12) && budget.has(numShapes, 8);
+    snapshot->shapes.clear();
+    snapshot->bodies.clear();
+    if (ok) {
+      snapshot->shapes.resize(numShapes);
+    }
+    for (uint32_t i = 0; ok && i < numShapes; ++i) {
+      ok = readShape(file, &budget, &snapshot->shapes[i]);
+    }
+    ok = ok && readU32(file, &numBodies) && budget.take(4) && budget.take(numBodies, SNAPSHOT_BODY_WORDS * 4);
+    if (ok) {
+      // The bodies are all the same size, so they're read in one go and only then taken apart
+      std::vector<uint8_t> bytes((size_t) numBodies * SNAPSHOT_BODY_WORDS * 4);
+      ok = fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+      snapshot->bodies.resize(ok ? numBodies : 0);
+      for (uint32_t i = 0; ok && i < numBodies; ++i) {
+        uint32_t words[SNAPSHOT_BODY_WORDS];
+        for (uint32_t word = 0; word < SNAPSHOT_BODY_WORDS; ++word) {
+          words[word] = decodeU32(&bytes[((size_t) i * SNAPSHOT_BODY_WORDS + word) * 4]);
+        }
+        memcpy(&snapshot->bodies[i], words, sizeof(words));
+        ok = snapshot->bodies[i].shape < numShapes;
+      }
+    }
+    fclose(file);
+    if (!ok) {
+      fprintf(stderr, "'%s' is not a valid physics snapshot\n", path.c_str());
+      snapshot->shapes.clear();
+      snapshot->bodies.clear();
+    }
+    return ok;
+  }
+
+  bool savePhysicsSnapshot(const std::string& path, const PhysicsSnapshot& snapshot) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+      fprintf(stderr, "Failed to open physics snapshot '%s' for writing\n", path.c_str());
+      return false;
+    }
+    bool ok = writeMagic(file, snapshotMagic)
+              && writeU32(file, PHYSICS_SNAPSHOT_VERSION)
+              && writeU32(file, (uint32_t) snapshot.shapes.size());
+    for (auto& shape : snapshot.shapes) {
+      ok = ok && writeU32(file, shape.kind);
+      switch (shape.kind) {
+        case SnapshotShape::SPHERE:
+          ok = ok && writeFloat(file, shape.radius);
+          break;
+        case SnapshotShape::HULL:
+          ok = ok && writeU32(file, (uint32_t) (shape.points.size() / 3));
+          for (size_t i = 0; ok && i < shape.points.size() / 3 * 3; ++i) {
+            ok = writeFloat(file, shape.points[i]);
+          }
+          break;
+        case SnapshotShape::HULL_FILE:
+          ok = ok && writeU32(file, (uint32_t) shape.file.size())
+               && fwrite(shape.file.data(), 1, shape.file.size(), file) == shape.file.size();
+          break;
+        default:
+          ok = false;
+          break;
+      }
+    }
+    ok = ok && writeU32(file, (uint32_t) snapshot.bodies.size());
+    std::vector<uint8_t> bytes((size_t) snapshot.bodies.size() * SNAPSHOT_BODY_WORDS * 4);
+    for (size_t i = 0; i < snapshot.bodies.size(); ++i) {
+      uint32_t words[SNAPSHOT_BODY_WORDS];
+      memcpy(words, &snapshot.bodies[i], sizeof(words));
+      for (uint32_t word = 0; word < SNAPSHOT_BODY_WORDS; ++word) {
+        encodeU32(words[word], &bytes[(i * SNAPSHOT_BODY_WORDS + word) * 4]);
+      }
+    }
+    ok = ok && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+      fprintf(stderr, "Failed to write physics snapshot '%s'\n", path.c_str());
+    }
+    return ok;
+  }
+}
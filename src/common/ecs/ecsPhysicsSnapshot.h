@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_PHYSICS_SNAPSHOT_H
+#define ECS_PHYSICS_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ecsEntityId.h"
+#include "ecsHullFile.h"
+
+namespace ecs {
+
+  /*
+   * Physics snapshots (.snap) hold every rigid body of a built physics world, along with the shapes they use and the
+   * entities they belonged to, so that a level can be brought back up without working any of it out again (see
+   * PhysicsSystem::saveSnapshot and loadSnapshot). Each distinct shape is stored once, however many bodies share it.
+   *
+   * Layout, every value little-endian:
+   *   char[4]  "SNAP"
+   *   uint32   format version (PHYSICS_SNAPSHOT_VERSION)
+   *   uint32   number of shapes
+   *   then for each shape:
+   *     uint32   kind (SnapshotShape::Kind)
+   *     SPHERE:    float radius
+   *     HULL:      uint32 number of points, then float x, y, z of each point
+   *     HULL_FILE: uint32 length of the path, then its characters
+   *   uint32   number of bodies
+   *   then every body, as SNAPSHOT_BODY_WORDS 32-bit words each, in the order of SnapshotBody's members
+   */
+  #define PHYSICS_SNAPSHOT_VERSION 1
+
+  struct SnapshotShape {
+    enum Kind {
+      SPHERE, HULL, HULL_FILE
+    };
+    uint32_t kind;
+    float radius;
+    HullPoints points;
+    std::string file;
+  };
+
+  struct SnapshotBody {
+    entityId id;           // the entity the body belonged to when it was saved
+    uint32_t shape;        // index into PhysicsSnapshot::shapes
+    float mass;
+    float inertia[3];      // the body's local inertia, so it needn't be computed from the shape again
+    float position[3];
+    float orientation[4];  // x, y, z, w
+    float linearVelocity[3];
+    float angularVelocity[3];
+    float friction, restitution;
+    uint32_t activationState;
+  };
+  #define SNAPSHOT_BODY_WORDS 22
+  static_assert(sizeof(SnapshotBody) == SNAPSHOT_BODY_WORDS * 4, "SnapshotBody must be made of 32-bit words only");
+
+  struct PhysicsSnapshot {
+    std::vector<SnapshotShape> shapes;
+    std::vector<SnapshotBody> bodies;
+  };
+
+  /**
+   * Reads the snapshot at 'path' into 'snapshot' (replacing whatever it held).
+   * @return false (with a message on stderr) if the file can't be read or isn't a valid snapshot
+   */
+  bool loadPhysicsSnapshot(const std::string& path, PhysicsSnapshot* snapshot);
+  /**
+   * @return false (with a message on stderr) if the file can't be written
+   */
+  bool savePhysicsSnapshot(const std::string& path, const PhysicsSnapshot& snapshot);
+}
+
+#endif //ECS_PHYSICS_SNAPSHOT_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "ecsPhysicsTaskScheduler.h"
+
+#if BT_THREADSAFE
+
+#include <vector>
+#include "../jobs/jobsParallelFor.h"
+
+namespace ecs {
+
+  PhysicsTaskScheduler::PhysicsTaskScheduler(jobs::WorkerPool* pool)
+      : btITaskScheduler("ecs"), pool(pool), numThreads(getMaxNumThreads()) { }
+  int PhysicsTaskScheduler::getMaxNumThreads() const {
+    int max = pool ? (int) pool->concurrency() : 1;
+    return max < BT_MAX_THREAD_COUNT ? max : BT_MAX_THREAD_COUNT;
+  }
+  int PhysicsTaskScheduler::getNumThreads() const {
+    return getMaxNumThreads();
+  }
+  void PhysicsTaskScheduler::setNumThreads(int numThreads) {
+    int max = getMaxNumThreads();
+    this->numThreads = numThreads < 1 ? 1 : (numThreads > max ? max : numThreads);
+  }
+  uint32_t PhysicsTaskScheduler::grainFor(int count, int grainSize) const {
+    uint32_t grain = grainSize > 0 ? (uint32_t) grainSize : 1;
+    uint32_t evenShare = ((uint32_t) count + numThreads - 1) / numThreads; // no more chunks than threads allowed
+    return grain > evenShare ? grain : evenShare;
+  }
+  void PhysicsTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) {
+    if (iEnd <= iBegin) {
+      return;
+    }
+    jobs::parallelFor(numThreads > 1 ? pool : nullptr, (uint32_t) (iEnd - iBegin), grainFor(iEnd - iBegin, grainSize),
+        [iBegin, &body](uint32_t begin, uint32_t end) {
+          body.forLoop(iBegin + (int) begin, iBegin + (int) end);
+        });
+  }
+  btScalar PhysicsTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) {
+    if (iEnd <= iBegin) {
+      return btScalar(0);
+    }
+    // One partial sum per chunk, added up in chunk order afterwards so that the result doesn't depend on timing
+    uint32_t grain = grainFor(iEnd - iBegin, grainSize);
+    std::vector<btScalar> sums(((uint32_t) (iEnd - iBegin) + grain - 1) / grain, btScalar(0));
+    btScalar* sum = sums.data();
+    jobs::parallelFor(numThreads > 1 ? pool : nullptr, (uint32_t) (iEnd - iBegin), grain,
+        [iBegin, grain, sum, &body](uint32_t begin, uint32_t end) {
+          sum[begin / grain] = body.sumLoop(iBegin + (int) begin, iBegin + (int) end);
+        });
+    btScalar total = btScalar(0);
+    for (btScalar partial : sums) {
+      total += partial;
+    }
+    return total;
+  }
+}
+
+#endif //BT_THREADSAFE
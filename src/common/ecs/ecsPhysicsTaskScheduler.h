@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_PHYSICS_TASK_SCHEDULER_H
+#define ECS_PHYSICS_TASK_SCHEDULER_H
+
+#include <btBulletDynamicsCommon.h>
+
+/*
+ * Bullet only hands work to a task scheduler when both it and everything including its headers are built with
+ * BT_THREADSAFE (see the BULLET_MULTITHREADED option in the top-level CMakeLists.txt). Otherwise there is nothing here.
+ */
+#if BT_THREADSAFE
+
+#if BT_BULLET_VERSION < 288
+#error "BULLET_MULTITHREADED needs Bullet 2.88 or newer"
+#endif
+
+#include <LinearMath/btThreads.h>
+#include "../jobs/jobsWorkerPool.h"
+
+namespace ecs {
+
+  /**
+   * PhysicsTaskScheduler - lets Bullet's multithreaded world (btDiscreteDynamicsWorldMt) spread its work across one of
+   * our WorkerPools, instead of starting its own set of threads.
+   *
+   * Bullet's parallel loops are split into chunks of at least the grain it asks for and run with jobs::parallelFor, so
+   * they can be started from a job (a system run by the Scheduler) as well as from the main thread.
+   * The pool's size is fixed when it is made, so setNumThreads only caps how many chunks a loop is split into (and so
+   * how many threads work on it at once). A single thread runs every loop on the calling thread.
+   * Any of the pool's threads may still run any chunk, and Bullet sizes its per-thread arrays by getNumThreads and
+   * indexes them by the running thread's index, so getNumThreads always reports the whole pool.
+   */
+  class PhysicsTaskScheduler : public btITaskScheduler {
+    public:
+      explicit PhysicsTaskScheduler(jobs::WorkerPool* pool);
+      virtual int getMaxNumThreads() const;
+      virtual int getNumThreads() const;
+      virtual void setNumThreads(int numThreads);
+      virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body);
+      virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body);
+
+    private:
+      jobs::WorkerPool* pool;
+      int numThreads; // as set by setNumThreads, the most chunks a loop is split into
+      uint32_t grainFor(int count, int grainSize) const;
+  };
+}
+
+#endif //BT_THREADSAFE
+
+#endif //ECS_PHYSICS_TASK_SCHEDULER_H
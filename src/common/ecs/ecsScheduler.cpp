@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdio>
+#include "ecsScheduler.h"
+
+namespace ecs {
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  static inline float millisSince(const Clock::time_point& start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+  }
+
+  Scheduler::Scheduler(jobs::WorkerPool* pool) : pool(pool) { }
+
+  void Scheduler::addNode(const char* name, compMask reads, compMask writes, void* system, TickFunc tickFunc) {
+    uint32_t index = (uint32_t) nodes.size();
+    nodes.emplace_back();
+    Node& node = nodes.back();
+    node.scheduler = this;
+    node.name = name;
+    node.reads = reads;
+    node.writes = writes;
+    node.system = system;
+    node.tickFunc = tickFunc;
+    node.numDependencies = 0;
+    node.milliseconds = 0.f;
+    for (uint32_t i = 0; i < index; ++i) {
+      Node& earlier = nodes[i];
+      if (earlier.writes.intersects(reads | writes) || writes.intersects(earlier.reads)) {
+        earlier.dependents.push_back(index);
+        ++node.numDependencies;
+      }
+    }
+    stats.systems.push_back({ name, 0.f });
+  }
+
+  void Scheduler::runNode(void* data) {
+    Node* node = reinterpret_cast<Node*>(data);
+    Scheduler* scheduler = node->scheduler;
+    Clock::time_point start = Clock::now();
+    node->tickFunc(node->system, scheduler->dt);
+    node->milliseconds = millisSince(start);
+    for (auto index : node->dependents) {
+      Node& dependent = scheduler->nodes[index];
+      if (--dependent.waitingOn == 0) {
+        scheduler->pool->submit({ &Scheduler::runNode, &dependent, nullptr });
+      }
+    }
+  }
+
+  void Scheduler::tick(float dt) {
+    this->dt = dt;
+    for (auto& node : nodes) {
+      node.waitingOn = node.numDependencies;
+    }
+    Clock::time_point start = Clock::now();
+    for (auto& node : nodes) {
+      if (node.numDependencies == 0) {
+        pool->submit({ &Scheduler::runNode, &node, nullptr });
+      }
+    }
+    pool->wait();
+    stats.wallMilliseconds = millisSince(start);
+    stats.busyMilliseconds = 0.f;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+      stats.systems[i].milliseconds = nodes[i].milliseconds;
+      stats.busyMilliseconds += nodes[i].milliseconds;
+    }
+    stats.parallelism = stats.wallMilliseconds > 0.f ? stats.busyMilliseconds / stats.wallMilliseconds : 1.f;
+  }
+
+  const Scheduler::FrameStats& Scheduler::getFrameStats() const {
+    return stats;
+  }
+
+  std::string Scheduler::getFrameReport() const {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "systems: %.3f ms wall, %.3f ms busy, parallelism %.2f",
+             stats.wallMilliseconds, stats.busyMilliseconds, stats.parallelism);
+    std::string report(buffer);
+    for (auto& system : stats.systems) {
+      snprintf(buffer, sizeof(buffer), " | %s %.3f ms", system.name, system.milliseconds);
+      report += buffer;
+    }
+    return report;
+  }
+}
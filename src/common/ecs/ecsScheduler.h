@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_SCHEDULER_H
+#define ECS_SCHEDULER_H
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include "ecsComponents.h"
+#include "../jobs/jobsWorkerPool.h"
+
+namespace ecs {
+
+  /**
+   * Scheduler - ticks a set of systems on a worker pool, running systems at the same time whenever they can't
+   * interfere with each other.
+   *
+   * Each system declares the component types it reads and writes (see System::getReadComponents). Two systems conflict
+   * if either one writes a component type that the other reads or writes. Systems are added in the order they should
+   * tick in, and a system waits only for those earlier systems it conflicts with. For example, MovementSystem (writes
+   * Scale) and ControlSystem (writes Orientation and WasdControls) run side by side, while PhysicsSystem, which reads
+   * WasdControls, waits for ControlSystem.
+   *
+   * Since systems may be running on other threads, they must not add or remove components or entities during tick
+   * (that fires delegates into other systems' registries). Record such changes in a CommandBuffer instead, and flush it
+   * after tick returns.
+   */
+  class Scheduler {
+    public:
+      struct SystemStats {
+        const char* name;
+        float milliseconds;
+      };
+      struct FrameStats {
+        float wallMilliseconds; // from the start of tick until every system had finished
+        float busyMilliseconds; // sum of the time spent in each system
+        float parallelism;      // busy time over wall time: 1 means no systems overlapped
+        std::vector<SystemStats> systems;
+      };
+
+      Scheduler(jobs::WorkerPool* pool);
+
+      template<typename SystemType>
+      void addSystem(SystemType& system, const char* name);
+
+      /**
+       * Ticks every system once, and returns when all have finished
+       */
+      void tick(float dt);
+
+      const FrameStats& getFrameStats() const;
+      /**
+       * @return a one-line summary of the last frame's stats, suitable for printing
+       */
+      std::string getFrameReport() const;
+
+    private:
+      typedef void (*TickFunc)(void* system, float dt);
+      struct Node {
+        Scheduler* scheduler;
+        const char* name;
+        compMask reads, writes;
+        void* system;
+        TickFunc tickFunc;
+        std::vector<uint32_t> dependents;
+        uint32_t numDependencies;
+        std::atomic<uint32_t> waitingOn;
+        float milliseconds;
+      };
+      jobs::WorkerPool* pool;
+      std::deque<Node> nodes; // a deque so that nodes never move once their address has been handed to a job
+      float dt = 0.f;
+      FrameStats stats;
+
+      void addNode(const char* name, compMask reads, compMask writes, void* system, TickFunc tickFunc);
+      static void runNode(void* data);
+      template<typename SystemType>
+      static void tickSystem(void* system, float dt) { static_cast<SystemType*>(system)->tick(dt); }
+  };
+
+  template<typename SystemType>
+  void Scheduler::addSystem(SystemType& system, const char* name) {
+    addNode(name, system.getReadComponents(), system.getWriteComponents(), &system, &tickSystem<SystemType>);
+  }
+}
+
+#endif //ECS_SCHEDULER_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <cstring>
+#include "ecsHullFile.h"
+#include "ecsShapeCache.h"
+
+namespace ecs {
+
+  static const uint64_t fnvOffset = 14695981039346656037ull;
+  static const uint64_t fnvPrime = 1099511628211ull;
+
+  static uint64_t hashFloats(uint64_t hash, const float* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      float value = values[i] == 0.f ? 0.f : values[i]; // so that -0 and 0 hash the same, since they compare equal
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      for (int byte = 0; byte < 4; ++byte) {
+        hash = (hash ^ ((bits >> (8 * byte)) & 0xff)) * fnvPrime;
+      }
+    }
+    return hash;
+  }
+
+  ShapeCache::~ShapeCache() {
+    for (auto& bucket : entries) {
+      for (auto& entry : bucket.second) {
+        deleteShape(entry.shape);
+      }
+    }
+  }
+
+  btCollisionShape* ShapeCache::getSphere(float radius) {
+    uint64_t hash = hashFloats(fnvOffset ^ SPHERE_SHAPE_PROXYTYPE, &radius, 1);
+    auto bucket = entries.find(hash);
+    if (bucket != entries.end()) {
+      for (auto& entry : bucket->second) {
+        if (entry.shape->getShapeType() == SPHERE_SHAPE_PROXYTYPE
+            && ((btSphereShape*) entry.shape)->getRadius() == radius) {
+          ++entry.users;
+          return entry.shape;
+        }
+      }
+    }
+    return addNew(hash, spheres.create(radius));
+  }
+
+  btCollisionShape* ShapeCache::getHull(const std::vector<float>& points) {
+    assert(points.size() % 3 == 0);
+    int numPoints = (int) points.size() / 3;
+    uint64_t hash = hashFloats(fnvOffset ^ CONVEX_HULL_SHAPE_PROXYTYPE, points.data(), points.size());
+    auto bucket = entries.find(hash);
+    if (bucket != entries.end()) {
+      for (auto& entry : bucket->second) {
+        if (entry.shape->getShapeType() != CONVEX_HULL_SHAPE_PROXYTYPE) {
+          continue;
+        }
+        btConvexHullShape* hull = (btConvexHullShape*) entry.shape;
+        if (hull->getNumPoints() != numPoints) {
+          continue;
+        }
+        const btVector3* hullPoints = hull->getUnscaledPoints();
+        bool same = true;
+        for (int i = 0; same && i < numPoints; ++i) {
+          same = hullPoints[i] == btVector3(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+        }
+        if (same) {
+          ++entry.users;
+          return entry.shape;
+        }
+      }
+    }
+    return addNew(hash, new btConvexHullShape(points.data(), numPoints, 3 * sizeof(float)));
+  }
+
+  btCollisionShape* ShapeCache::getHullFile(const std::string& path) {
+    uint64_t hash = fnvOffset ^ COMPOUND_SHAPE_PROXYTYPE;
+    for (char c : path) {
+      hash = (hash ^ (uint8_t) c) * fnvPrime;
+    }
+    auto bucket = entries.find(hash);
+    if (bucket != entries.end()) {
+      for (auto& entry : bucket->second) {
+        if (entry.file == path) {
+          ++entry.users;
+          return entry.shape;
+        }
+      }
+    }
+    std::vector<HullPoints> hulls;
+    if (!loadHullFile(path, &hulls)) {
+      return nullptr;
+    }
+    if (hulls.size() == 1) {
+      return addNew(hash, new btConvexHullShape(hulls[0].data(), (int) hulls[0].size() / 3, 3 * sizeof(float)), path);
+    }
+    // The parts of a decomposed mesh are baked in the mesh's own space, so each child sits at the compound's origin
+    btCompoundShape* compound = new btCompoundShape(false, (int) hulls.size());
+    btTransform identity;
+    identity.setIdentity();
+    for (auto& hull : hulls) {
+      compound->addChildShape(identity, new btConvexHullShape(hull.data(), (int) hull.size() / 3, 3 * sizeof(float)));
+    }
+    return addNew(hash, compound, path);
+  }
+
+  void ShapeCache::retain(btCollisionShape* shape) {
+    ++entryOf(shape).users;
+  }
+
+  const std::string& ShapeCache::getFile(btCollisionShape* shape) {
+    return entryOf(shape).file;
+  }
+
+  void ShapeCache::release(btCollisionShape* shape) {
+    auto hash = hashes.find(shape);
+    assert(hash != hashes.end());
+    std::vector<Entry>& bucket = entries[hash->second];
+    for (size_t i = 0; i < bucket.size(); ++i) {
+      if (bucket[i].shape != shape) {
+        continue;
+      }
+      if (--bucket[i].users == 0) {
+        deleteShape(shape);
+        bucket[i] = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty()) {
+          entries.erase(hash->second);
+        }
+        hashes.erase(hash);
+      }
+      return;
+    }
+    assert("released a shape that the cache doesn't hold" == nullptr);
+  }
+
+  size_t ShapeCache::size() const {
+    return hashes.size();
+  }
+
+  ShapeCache::Entry& ShapeCache::entryOf(btCollisionShape* shape) {
+    auto hash = hashes.find(shape);
+    assert(hash != hashes.end());
+    for (auto& entry : entries[hash->second]) {
+      if (entry.shape == shape) {
+        return entry;
+      }
+    }
+    assert("the cache doesn't hold this shape" == nullptr);
+    return entries[hash->second].front();
+  }
+
+  btCollisionShape* ShapeCache::addNew(uint64_t hash, btCollisionShape* shape, const std::string& file) {
+    entries[hash].push_back({ shape, 1, file });
+    hashes[shape] = hash;
+    return shape;
+  }
+
+  void ShapeCache::deleteShape(btCollisionShape* shape) {
+    if (shape->getShapeType() == SPHERE_SHAPE_PROXYTYPE) {
+      spheres.destroy((btSphereShape*) shape);
+      return;
+    }
+    // The children of compound shapes (made from hull files) belong to the compound
+    if (shape->getShapeType() == COMPOUND_SHAPE_PROXYTYPE) {
+      btCompoundShape* compound = (btCompoundShape*) shape;
+      for (int i = 0; i < compound->getNumChildShapes(); ++i) {
+        delete compound->getChildShape(i);
+      }
+    }
+    delete shape;
+  }
+}
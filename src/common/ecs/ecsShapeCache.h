@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_SHAPE_CACHE_H
+#define ECS_SHAPE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <btBulletDynamicsCommon.h>
+#include "ecsSlabAllocator.h"
+
+namespace ecs {
+
+  /**
+   * ShapeCache - hands out one shared collision shape per distinct geometry, so that a crowd of entities with the same
+   * sphere radius or the same hull uses a single btCollisionShape between them.
+   *
+   * Each get call counts a new user of the shape it returns, and each release call drops one. The shape is deleted when
+   * its last user releases it. Shapes are told apart by geometry type and parameters (the radius, every point of the
+   * hull, or the path of the hull file), looked up by a hash of those.
+   */
+  class ShapeCache {
+    public:
+      ShapeCache() { }
+      ~ShapeCache();
+      btCollisionShape* getSphere(float radius);
+      /**
+       * @param points the hull's vertices as consecutive x, y, z triples
+       */
+      btCollisionShape* getHull(const std::vector<float>& points);
+      /**
+       * Loads the hulls baked into a hull file (see ecsHullFile.h) the first time 'path' is asked for.
+       * @return a btConvexHullShape for a single hull or a btCompoundShape of them for several, or null (without
+       *         counting a user) if the file couldn't be loaded
+       */
+      btCollisionShape* getHullFile(const std::string& path);
+      /**
+       * Counts another user of a shape the cache already holds, without looking up its geometry again
+       */
+      void retain(btCollisionShape* shape);
+      void release(btCollisionShape* shape);
+      /**
+       * @return the path of the hull file a held shape was loaded from, or an empty string if it wasn't
+       */
+      const std::string& getFile(btCollisionShape* shape);
+      /**
+       * @return the number of distinct shapes currently held
+       */
+      size_t size() const;
+      /**
+       * @return how sphere shapes (the only kind a scene is likely to hold many of) have been allocated
+       */
+      const SlabAllocator<btSphereShape, 64>::Stats& sphereStats() const { return spheres.stats(); }
+
+    private:
+      ShapeCache(const ShapeCache&) = delete;
+      ShapeCache& operator=(const ShapeCache&) = delete;
+      struct Entry {
+        btCollisionShape* shape;
+        uint32_t users;
+        std::string file; // for shapes loaded from hull files
+      };
+      // Different geometries with the same hash share a bucket, and are told apart by comparing their parameters
+      std::unordered_map<uint64_t, std::vector<Entry>> entries;
+      std::unordered_map<btCollisionShape*, uint64_t> hashes;
+      SlabAllocator<btSphereShape, 64> spheres;
+      Entry& entryOf(btCollisionShape* shape);
+      btCollisionShape* addNew(uint64_t hash, btCollisionShape* shape, const std::string& file = std::string());
+      void deleteShape(btCollisionShape* shape);
+  };
+}
+
+#endif //ECS_SHAPE_CACHE_H
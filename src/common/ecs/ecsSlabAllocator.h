@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ECS_SLAB_ALLOCATOR_H
+#define ECS_SLAB_ALLOCATOR_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+  /**
+   * SlabAllocator - hands out memory for objects of one type from slabs of 'slotsPerSlab' slots at a time, aligned to
+   * at least 16 bytes (what Bullet's SIMD types need). Freed slots go on a free list and are handed out again before
+   * any new slab is made, so once a system has seen its peak number of objects, making and destroying them costs no
+   * heap traffic at all. Slabs are only given back when the allocator is destroyed.
+   * Not thread safe: PhysicsSystem only makes and destroys bodies while structural changes are being made.
+   */
+  template<typename T, uint32_t slotsPerSlab = 256>
+  class SlabAllocator {
+    public:
+      struct Stats {
+        uint64_t allocations; // slots handed out, ever
+        uint64_t frees;       // slots given back, ever
+        uint64_t heapAllocations; // slabs made, ever (the only time the heap is touched)
+        uint32_t live;        // slots in use right now
+      };
+
+      SlabAllocator() { }
+      ~SlabAllocator();
+
+      template<typename ... types>
+      T* create(types&&... args) {
+        return new (allocate()) T(std::forward<types>(args)...);
+      }
+      void destroy(T* object) {
+        if (object) {
+          object->~T();
+          free(object);
+        }
+      }
+      void* allocate();
+      void free(void* slot);
+      const Stats& stats() const { return counts; }
+
+    private:
+      SlabAllocator(const SlabAllocator&) = delete;
+      SlabAllocator& operator=(const SlabAllocator&) = delete;
+      static const size_t alignment = alignof(T) > 16 ? alignof(T) : 16;
+      union Slot {
+        Slot* next;
+        unsigned char storage[sizeof(T)];
+      };
+      static const size_t slotSize = (sizeof(Slot) + alignment - 1) / alignment * alignment;
+      std::vector<void*> slabs; // as returned by malloc, before aligning
+      Slot* freeList = nullptr;
+      Stats counts = { 0, 0, 0, 0 };
+      void addSlab();
+  };
+
+  template<typename T, uint32_t slotsPerSlab>
+  SlabAllocator<T, slotsPerSlab>::~SlabAllocator() {
+    assert(counts.live == 0); // every object should have been destroyed by now
+    for (void* slab : slabs) {
+      ::free(slab);
+    }
+  }
+
+  template<typename T, uint32_t slotsPerSlab>
+  void* SlabAllocator<T, slotsPerSlab>::allocate() {
+    if (!freeList) {
+      addSlab();
+    }
+    Slot* slot = freeList;
+    freeList = slot->next;
+    ++counts.allocations;
+    ++counts.live;
+    return slot;
+  }
+
+  template<typename T, uint32_t slotsPerSlab>
+  void SlabAllocator<T, slotsPerSlab>::free(void* slot) {
+    assert(slot && counts.live > 0);
+    Slot* freed = reinterpret_cast<Slot*>(slot);
+    freed->next = freeList;
+    freeList = freed;
+    ++counts.frees;
+    --counts.live;
+  }
+
+  template<typename T, uint32_t slotsPerSlab>
+  void SlabAllocator<T, slotsPerSlab>::addSlab() {
+    void* slab = malloc(slotSize * slotsPerSlab + alignment - 1);
+    assert(slab != nullptr);
+    slabs.push_back(slab);
+    ++counts.heapAllocations;
+    uintptr_t first = ((uintptr_t) slab + alignment - 1) / alignment * alignment;
+    // Thread the new slots onto the free list so that they're handed out in address order
+    for (uint32_t i = slotsPerSlab; i-- > 0; ) {
+      Slot* slot = reinterpret_cast<Slot*>(first + i * slotSize);
+      slot->next = freeList;
+      freeList = slot;
+    }
+  }
+}
+
+#endif //ECS_SLAB_ALLOCATOR_H
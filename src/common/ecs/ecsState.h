@@ -23,13 +23,14 @@
 #ifndef ECS_STATE_H
 #define ECS_STATE_H
 
-#include <stack>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <tuple>
 #include <vector>
-#include "ecsAutoGen.h"
 #include "ecsComponents.h"
 #include "ecsDelegate.h"
-#include "ecsKvMap.h"
+#include "ecsCompPool.h"
 
 namespace ecs {
 
@@ -53,53 +54,89 @@ namespace ecs {
     PREREQ_FAIL,
     DEPEND_FAIL,
     MAX_ID_REACHED,
+    CONFLICTING_CMDS,
   };
 
+  template<typename ... comps>
+  class BasicCommandBuffer;
+
   /**
    * EcsState - Entity Component System State
    * Within is contained all game state data pertaining to the ecs. This data takes the form of lots and lots
-   * of components stored in key-value mapped structures, where the keys are entity IDs and the values are the
-   * components themselves. Entities per se only exist as associations between components that share the same ID.
+   * of components stored in sparse sets (see ecsCompPool.h), one per component type, indexed by entity ID.
+   * Entities per se only exist as associations between components that share the same ID.
+   *
+   * BasicState holds one pool for each of the component types it is given (which must include Existence), in a
+   * tuple, so every accessor below picks its pool at compile time. The game's state is State (see below), which holds
+   * every type in AllComps. The following methods exist for each component type (examples given for imaginary
+   * component 'FakeComponent'):
+   *
+   * * * COMPONENT ADDITION * * *
+   * SYNTAX:  CompOpReturn add<[component_type]>(entityId id, [applicable constructor arguments])
+   *          CompOpReturn add<[component_type]>(entityId id, const [component_type]& copyThis)
+   * EXAMPLE: CompOpReturn result = add<FakeComponent>(someId, madeUpConstructorArgument);
+   * RETURNS: SUCCESS,
+   *          REDUNDANT if component of same type already exists at that ID,
+   *          PREREQ_FAIL if entity at that ID doesn't possess the required components for the requested component
+   *                      to be made (i.e. if you tried to give it a velocity before giving it a position),
+   *          NONEXISTENT_ENT if no entity exists at that ID to which to add the requested component.
+   *
+   * * * COMPONENT REMOVAL * * *
+   * SYNTAX:  CompOpReturn rem<[component_type]>(entityId id)
+   * EXAMPLE: CompOpReturn result = rem<FakeComponent>(someId);
+   * RETURNS: SUCCESS,
+   *          DEPEND_FAIL if other components at that ID depend on the component you're trying to remove,
+   *          NONEXISTENT_ENT if no entity exists at that ID from which to remove the requested component,
+   *          NONEXISTENT_COMP if the component you're trying to remove doesn't exist at that ID.
+   *
+   * * * COMPONENT RETREIVAL * * *
+   * SYNTAX:  CompOpReturn get<[component_type]>(entityId id, [component_type]** out)
+   *          [component_type]* get<[component_type]>(entityId id)
+   * Example: CompOpReturn result = get<FakeComponent>(someId, &myPtr);
+   *          FakeComponent* myPtr = get<FakeComponent>(someId);
+   * RETURNS: SUCCESS,
+   *          NONEXISTENT_COMP if the component you're trying to access doesn't exist at that ID.
+   *          (the second form returns the component, or nullptr if it doesn't exist)
+   * NOTE:    The pointer obtained is only valid until the next addition or removal of a component of that type.
+   *
+   * * * CHANGE TRACKING * * *
+   * Every component remembers the tick in which it was last changed, so that anything only interested in changes
+   * (transform caches, network replication, uploads to the GPU) can skip the rest. The state only knows a component
+   * changed when told so, by markChanged<[component_type]>(id) or by getting it with getForWrite<[component_type]>(id).
+   * Adding a component counts as changing it. The game advances the tick once per frame (see Game::mainLoop), so a
+   * consumer that runs at the same point every frame can remember currentTick() when it runs and pass it back to
+   * changedSince or forEachChanged the next time. One that runs while the systems are still making changes may be
+   * handed the changes made after it ran in the same tick again next time, and should remember currentTick() - 1.
    */
-  class State {
-      // TODO: add methods to add components by copy: add[component_name](component_name& copyThis)
-      /**
-       * GEN_COLL_DECLS is defined in ecsComponents.h and simply wraps calls to the COMP_COLL_DECL macro.
-       * The COMP_COLL_DECL (Component Collection Declaration) macros DECLARE collections of each type of component,
-       * as well as methods to access and modify said collections. The following methods are generated (examples given
-       * for imaginary component 'FakeComponent'):
-       *
-       * * * COMPONENT ADDITION * * *
-       * SYNTAX:  CompOpReturn add[component_name](entityId id, [applicable constructor arguments])
-       * EXAMPLE: CompOpReturn result = addFakeComponent(someId, madeUpConstructorArgument);
-       * RETURNS: SUCCESS,
-       *          REDUNDANT if component of same type already exists at that ID,
-       *          PREREQ_FAIL if entity at that ID doesn't possess the required components for the requested component
-       *                      to be made (i.e. if you tried to give it a velocity before giving it a position),
-       *          NONEXISTENT_ENT if no entity exists at that ID to which to add the requested component.
-       *
-       * * * COMPONENT REMOVAL * * *
-       * SYNTAX:  CompOpReturn rem[component_name](entityId id)
-       * EXAMPLE: CompOpReturn result = remFakeComponent(someId);
-       * RETURNS: SUCCESS,
-       *          DEPEND_FAIL if other components at that ID depend on the component you're trying to remove,
-       *          NONEXISTENT_ENT if no entity exists at that ID from which to remove the requested component,
-       *          NONEXISTENT_COMP if the component you're trying to remove doesn't exist at that ID.
-       *
-       * * * COMPONENT RETREIVAL * * *
-       * SYNTAX:  CompOpReturn get[component_name](entityId id, [component_name]** out)
-       * Example: CompOpReturn result = getFakeComponent(someId, FakeComponent** myPtr);
-       * RETURNS: SUCCESS,
-       *          NONEXISTENT_COMP if the component you're trying to access doesn't exist at that ID.
-       */
-      GEN_COLL_DECLS
+  template<typename ... comps>
+  class BasicState {
+      template<typename ... types>
+      friend class BasicCommandBuffer;
+
+      typedef CompList<comps...> Comps;
+      static_assert(sizeof...(comps) <= CompMask::numBits, "Too many component types");
+      static_assert(allOf((std::is_same<comps, Existence>::value || comps::requiredComps().hasAll(ENUM_Existence))...),
+                    "Every component type but Existence must require ENUM_Existence");
+      static_assert(allOf(!comps::requiredComps().hasAny(comps::flag)...),
+                    "A component type can't require itself");
+      static_assert(allOf(maskOf(Comps()).hasAll(comps::requiredComps())...),
+                    "A component type requires another that this state doesn't hold");
+      static_assert(allOf(requirementsClosed<comps>(Comps())...),
+                    "A component type must also require whatever the components it requires do");
+
+      std::tuple<CompPool<entityId, comps>...> pools;
+      EntNotifyDelegates addCallbacks[sizeof...(comps)];
+      EntNotifyDelegates remCallbacks[sizeof...(comps)];
+      EntityIdAllocator idAllocator;
+      std::atomic<uint32_t> tick; // 0 is reserved for "never changed"
 
     public:
+      BasicState() : tick(1) { }
 
       /**
        * Creates a new entity (specifically an Existence component]
        * @param newId is set to the id of the newly created entity, or 0 if unsuccessful.
-       * @return SUCCESS or MAX_ID_REACHED if the maximum value of the entityId type has been reached
+       * @return SUCCESS or MAX_ID_REACHED if every entity index is in use or retired (see ecsEntityId.h)
        */
       CompOpReturn createEntity(entityId *newId);
 
@@ -111,12 +148,21 @@ namespace ecs {
       CompOpReturn clearEntity(const entityId& id);
 
       /**
-       * Deletes an entity. It's ID may be re-used later, so this 'invalidates' the ID
+       * Deletes an entity. Its index may be re-used later, but under a new generation, so the old ID (and any copies
+       * of it held elsewhere) will be rejected by every accessor from now on.
        * @param id The entity ID of the entity you wish to delete
-       * @return any of the possible return values of remExistence given that ID (see above)
+       * @return SUCCESS or NONEXISENT_ENT if no entity exists at that id
        */
       CompOpReturn deleteEntity(const entityId& id);
 
+      /**
+       * Deletes many entities at once. Each removal delegate is given every ID in one pass, rather than every delegate
+       * being fired once per entity. IDs that don't refer to an existing entity (or appear more than once) are skipped.
+       * @param ids The IDs of the entities you wish to delete
+       * @return SUCCESS or NONEXISTENT_ENT if any of the ids had no entity
+       */
+      CompOpReturn deleteEntities(std::vector<entityId> ids);
+
       /**
        * Use if you want to fire a callback whenever an entity with at least the components described by 'likeness'
        * comes into or leaved existence.
@@ -127,22 +173,398 @@ namespace ecs {
       void listenForLikeEntities(const compMask& likeness,
                                  EntNotifyDelegate&& additionDelegate, EntNotifyDelegate&& removalDelegate);
 
-    private:
-      entityId nextId = 0;
-      std::stack<entityId> freedIds;
+      template<typename compType, typename ... types>
+      CompOpReturn add(const entityId& id, const types &... args);
+      template<typename compType>
+      CompOpReturn rem(const entityId& id);
+      template<typename compType>
+      CompOpReturn get(const entityId& id, compType** out) {
+        compType* comp = pool<compType>().find(id);
+        if (comp) {
+          *out = comp;
+          return SUCCESS;
+        }
+        return NONEXISTENT_COMP;
+      }
+      template<typename compType>
+      compType* get(const entityId& id) {
+        return pool<compType>().find(id);
+      }
+
+      /**
+       * @return the current tick, which every change made from now until the next advanceTick() is marked with
+       */
+      uint32_t currentTick() const {
+        return tick.load(std::memory_order_relaxed);
+      }
+      /**
+       * Starts a new tick.
+       * @return the new tick
+       */
+      uint32_t advanceTick() {
+        return ++tick;
+      }
+      /**
+       * Marks the component at 'id' as changed in the current tick. Safe to call from several threads at once, as
+       * long as no two of them pass the same entity.
+       * @return SUCCESS or NONEXISTENT_COMP
+       */
+      template<typename compType>
+      CompOpReturn markChanged(const entityId& id) {
+        if (!pool<compType>().contains(id)) {
+          return NONEXISTENT_COMP;
+        }
+        pool<compType>().markChanged(id, currentTick());
+        return SUCCESS;
+      }
+      /**
+       * Same as get<compType>(id), but also marks the component as changed
+       */
+      template<typename compType>
+      compType* getForWrite(const entityId& id) {
+        compType* comp = pool<compType>().find(id);
+        if (comp) {
+          pool<compType>().markChanged(id, currentTick());
+        }
+        return comp;
+      }
+      /**
+       * @return true if the component at 'id' exists and was changed after tick 'since'
+       */
+      template<typename compType>
+      bool changedSince(const entityId& id, uint32_t since) {
+        return pool<compType>().version(id) > since;
+      }
+      /**
+       * Calls 'fn(const entityId&, compType&)' for every component of that type changed after tick 'since'.
+       * The work done is proportional to the number of changes rather than to the number of components.
+       */
+      template<typename compType, typename Fn>
+      void forEachChanged(uint32_t since, Fn fn) {
+        pool<compType>().forEachChangedSince(since, fn);
+      }
+
+      /**
+       * The pool holding every component of one type, for systems that want to walk all of them directly
+       */
+      template<typename compType>
+      CompPool<entityId, compType>& pool() {
+        return std::get<CompIndex<compType, comps...>::value>(pools);
+      }
 
+    private:
+      template<typename compType>
+      static constexpr uint32_t slot() { return CompIndex<compType, comps...>::value; }
+      template<typename compType>
+      void clearComp(const entityId& id);
+      template<typename compType>
+      void deleteComp(const entityId& id);
+      template<typename compType>
+      void deleteComps(const std::vector<entityId>& ids);
+      template<typename compType>
+      void listenForComp(const compMask& likeness,
+                         const EntNotifyDelegate& additionDelegate, const EntNotifyDelegate& removalDelegate);
       /*
-       * These are used by macros to generate the functions listed above (in the comment for GEN_COLL_DECLS
+       * Batched versions of add and rem used by BasicCommandBuffer (see ecsCommandBuffer.h). All of the changes are
+       * made first, and then each delegate is fired for the qualifying entities in a single pass.
+       * These return SUCCESS or the first failure encountered, and skip only the operations that failed.
        */
-      template<typename compType, typename ... types>
-      CompOpReturn addComp(KvMap<entityId, compType>& coll, const entityId& id,
-                           const EntNotifyDelegates& callbacks, const types &... args);
       template<typename compType>
-      CompOpReturn remComp(KvMap<entityId, compType>& coll, const entityId& id, const EntNotifyDelegates& callbacks);
+      CompOpReturn addBatch(std::vector<std::pair<entityId, compType>>& adds);
       template<typename compType>
-      CompOpReturn getComp(KvMap<entityId, compType>& coll, const entityId& id, compType** out);
+      CompOpReturn remBatch(const std::vector<entityId>& ids);
+      std::vector<entityId> batchScratch;
+  };
+
+  /*
+   * Compatibility shim for code written against the old generated accessors: add[component_type](id, ...),
+   * rem[component_type](id) and get[component_type](id, &out) each just forward to add, rem or get above.
+   * TODO: If you really need the old names for a new component type, add a line for it to State below.
+   */
+  #define ECS_COMPAT_ACCESSORS(comp) \
+    template<typename ... types> \
+    CompOpReturn add##comp(const entityId& id, const types &... args) { return add<comp>(id, args...); } \
+    CompOpReturn rem##comp(const entityId& id) { return rem<comp>(id); } \
+    CompOpReturn get##comp(const entityId& id, comp** out) { return get<comp>(id, out); }
+
+  /**
+   * The state of the game: one pool for every type in AllComps.
+   */
+  class State : public ApplyComps<BasicState, AllComps>::type {
+    public:
+      ECS_COMPAT_ACCESSORS(Existence)
+      ECS_COMPAT_ACCESSORS(Position)
+      ECS_COMPAT_ACCESSORS(Scale)
+      ECS_COMPAT_ACCESSORS(ScalarMultFunc)
+      ECS_COMPAT_ACCESSORS(Orientation)
+      ECS_COMPAT_ACCESSORS(Perspective)
+      ECS_COMPAT_ACCESSORS(WasdControls)
+      ECS_COMPAT_ACCESSORS(MouseControls)
+      ECS_COMPAT_ACCESSORS(Physics)
+      ECS_COMPAT_ACCESSORS(Trigger)
+
+      /**
+       * Copies every Position and Orientation into its 'last' value, so that whatever the next simulation tick changes
+       * can be drawn interpolated between the two (see Position::getVec and Orientation::getQuat).
+       * Only components whose 'last' value actually changes are marked as changed.
+       */
+      void capturePreviousState() {
+        CompPool<entityId, Position>& positions = pool<Position>();
+        const entityId* positionIds = positions.keys();
+        Position* position = positions.data();
+        for (uint32_t i = 0; i < (uint32_t) positions.size(); ++i) {
+          if (position[i].lastVec != position[i].vec) {
+            position[i].lastVec = position[i].vec;
+            positions.markChanged(positionIds[i], currentTick());
+          }
+        }
+        CompPool<entityId, Orientation>& orientations = pool<Orientation>();
+        const entityId* orientationIds = orientations.keys();
+        Orientation* orientation = orientations.data();
+        for (uint32_t i = 0; i < (uint32_t) orientations.size(); ++i) {
+          if (orientation[i].lastQuat != orientation[i].quat) {
+            orientation[i].lastQuat = orientation[i].quat;
+            orientations.markChanged(orientationIds[i], currentTick());
+          }
+        }
+      }
   };
 
+  template<typename ... comps>
+  CompOpReturn BasicState<comps...>::createEntity(entityId *newId) {
+    entityId id;
+    if (!idAllocator.create(&id)) {
+      *newId = 0; // ID 0 is never a valid id
+      return MAX_ID_REACHED;
+    }
+    pool<Existence>().emplace(id);
+    pool<Existence>().at(id).turnOnFlags(Existence::flag);
+    pool<Existence>().markChanged(id, currentTick());
+    *newId = id;
+    return SUCCESS;
+  }
+
+  template<typename ... comps>
+  CompOpReturn BasicState<comps...>::clearEntity(const entityId& id) {
+    if (!pool<Existence>().contains(id)) {
+      return NONEXISTENT_ENT;
+    }
+    int expand[] = { 0, (clearComp<comps>(id), 0)... };
+    (void) expand;
+    return SUCCESS;
+  }
+
+  template<typename ... comps>
+  CompOpReturn BasicState<comps...>::deleteEntity(const entityId& id) {
+    if (!pool<Existence>().contains(id)) {
+      return NONEXISTENT_ENT;
+    }
+    int expand[] = { 0, (deleteComp<comps>(id), 0)... };
+    (void) expand;
+    idAllocator.release(id);
+    return SUCCESS;
+  }
+
+  template<typename ... comps>
+  CompOpReturn BasicState<comps...>::deleteEntities(std::vector<entityId> ids) {
+    CompOpReturn status = SUCCESS;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [&](const entityId& id) {
+      if (!pool<Existence>().contains(id)) {
+        status = NONEXISTENT_ENT;
+        return true;
+      }
+      return false;
+    }), ids.end());
+    int expand[] = { 0, (deleteComps<comps>(ids), 0)... };
+    (void) expand;
+    for (auto id : ids) {
+      idAllocator.release(id);
+    }
+    return status;
+  }
+
+  template<typename ... comps>
+  void BasicState<comps...>::listenForLikeEntities(const compMask& likeness,
+                                                   EntNotifyDelegate&& additionDelegate,
+                                                   EntNotifyDelegate&& removalDelegate) {
+    int expand[] = { 0, (listenForComp<comps>(likeness, additionDelegate, removalDelegate), 0)... };
+    (void) expand;
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicState<comps...>::clearComp(const entityId& id) {
+    if (std::is_same<compType, Existence>::value) {
+      return;
+    }
+    Existence& existence = pool<Existence>().at(id);
+    if (existence.flagIsOn(compType::flag)) {
+      existence.turnOffFlags(compType::flag);
+      for (auto dlgt : remCallbacks[slot<compType>()]) {
+        if (!pool<Existence>().at(id).componentsPresent.contains(dlgt.likeness)) {
+          dlgt.fire(id);
+        }
+      }
+    }
+    pool<compType>().erase(id);
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicState<comps...>::deleteComp(const entityId& id) {
+    for (auto dlgt : remCallbacks[slot<compType>()]) { // give that id to all removal delegates no matter what
+      dlgt.fire(id);
+    }
+    pool<compType>().erase(id); // delete all component data for that id if it exists
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicState<comps...>::deleteComps(const std::vector<entityId>& ids) {
+    for (auto dlgt : remCallbacks[slot<compType>()]) { // one pass over all of the ids per removal delegate
+      for (auto& id : ids) {
+        dlgt.fire(id);
+      }
+    }
+    for (auto& id : ids) {
+      pool<compType>().erase(id);
+    }
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  void BasicState<comps...>::listenForComp(const compMask& likeness,
+                                           const EntNotifyDelegate& additionDelegate,
+                                           const EntNotifyDelegate& removalDelegate) {
+    if (likeness.intersects(compType::flag)) {
+      addCallbacks[slot<compType>()].push_back(additionDelegate);
+      remCallbacks[slot<compType>()].push_back(removalDelegate);
+    }
+  }
+
+  template<typename ... comps>
+  template<typename compType, typename ... types>
+  CompOpReturn BasicState<comps...>::add(const entityId& id, const types &... args) {
+    Existence* existence = pool<Existence>().find(id);
+    if (existence) {
+      if (existence->passesPrerequisitesForAddition(compType::requiredComps())) {
+        if (pool<compType>().emplace(id, args...)) {
+          pool<compType>().markChanged(id, currentTick());
+          existence->turnOnFlags(compType::flag);
+          for (auto dlgt : addCallbacks[slot<compType>()]) {
+            if (pool<Existence>().at(id).componentsPresent.contains(dlgt.likeness)) {
+              dlgt.fire(id);
+            }
+          }
+          return SUCCESS;
+        }
+        return REDUNDANT;
+      }
+      return PREREQ_FAIL;
+    }
+    return NONEXISTENT_ENT;
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  CompOpReturn BasicState<comps...>::rem(const entityId& id) {
+    if (pool<compType>().contains(id)) {
+      Existence* existence = pool<Existence>().find(id);
+      if (existence) {
+        if (existence->passesDependenciesForRemoval(compType::dependentComps())) {
+          if (!std::is_same<compType, Existence>::value) {
+            existence->turnOffFlags(compType::flag);
+          }
+          for (auto dlgt : remCallbacks[slot<compType>()]) { // fired before erasure so that they can still see it
+            if (!pool<Existence>().at(id).componentsPresent.contains(dlgt.likeness)) {
+              dlgt.fire(id);
+            }
+          }
+          pool<compType>().erase(id);
+          return SUCCESS;
+        }
+        return DEPEND_FAIL;
+      }
+      return NONEXISTENT_ENT;
+    }
+    return NONEXISTENT_COMP;
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  CompOpReturn BasicState<comps...>::addBatch(std::vector<std::pair<entityId, compType>>& adds) {
+    CompOpReturn status = SUCCESS;
+    CompPool<entityId, compType>& coll = pool<compType>();
+    batchScratch.clear();
+    coll.reserve(coll.size() + adds.size());
+    for (auto& add : adds) {
+      Existence* existence = pool<Existence>().find(add.first);
+      CompOpReturn result = SUCCESS;
+      if (!existence) {
+        result = NONEXISTENT_ENT;
+      } else if (!existence->passesPrerequisitesForAddition(compType::requiredComps())) {
+        result = PREREQ_FAIL;
+      } else if (!coll.emplace(add.first, std::move(add.second))) {
+        result = REDUNDANT;
+      } else {
+        coll.markChanged(add.first, currentTick());
+        existence->turnOnFlags(compType::flag);
+        batchScratch.push_back(add.first);
+      }
+      if (status == SUCCESS) {
+        status = result;
+      }
+    }
+    for (auto dlgt : addCallbacks[slot<compType>()]) {
+      for (auto id : batchScratch) {
+        if (pool<Existence>().at(id).componentsPresent.contains(dlgt.likeness)) {
+          dlgt.fire(id);
+        }
+      }
+    }
+    return status;
+  }
+
+  template<typename ... comps>
+  template<typename compType>
+  CompOpReturn BasicState<comps...>::remBatch(const std::vector<entityId>& ids) {
+    CompOpReturn status = SUCCESS;
+    CompPool<entityId, compType>& coll = pool<compType>();
+    batchScratch.clear();
+    for (auto id : ids) {
+      Existence* existence = pool<Existence>().find(id);
+      CompOpReturn result = SUCCESS;
+      if (!coll.contains(id)) {
+        result = NONEXISTENT_COMP;
+      } else if (!existence) {
+        result = NONEXISTENT_ENT;
+      } else if (!existence->passesDependenciesForRemoval(compType::dependentComps())) {
+        result = DEPEND_FAIL;
+      } else {
+        if (!std::is_same<compType, Existence>::value) {
+          existence->turnOffFlags(compType::flag);
+        }
+        batchScratch.push_back(id);
+      }
+      if (status == SUCCESS) {
+        status = result;
+      }
+    }
+    for (auto dlgt : remCallbacks[slot<compType>()]) {
+      for (auto id : batchScratch) {
+        if (!pool<Existence>().at(id).componentsPresent.contains(dlgt.likeness)) {
+          dlgt.fire(id);
+        }
+      }
+    }
+    for (auto id : batchScratch) {
+      coll.erase(id);
+    }
+    return status;
+  }
+
 }
 
 #endif //ECS_STATE_H
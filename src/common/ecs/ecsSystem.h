@@ -25,14 +25,22 @@
 
 #include <string>
 #include <vector>
-#include <algorithm>
+#include <cassert>
 #include "ecsState.h"
+#include "../jobs/jobsParallelFor.h"
 
 namespace ecs {
 
   typedef Delegate<bool(const entityId& id)> entNotifyHandler;
   static bool doNothing(const entityId&) { return true; }
 
+  /**
+   * The list of IDs of all entities a system is interested in (those with at least some set of components).
+   * Alongside the list is a table, indexed by entity index, of each ID's position in the list, so finding or
+   * removing an ID doesn't require searching the list. By default, an ID is removed by moving the last ID into its
+   * place. If a system needs its IDs to stay in the order they were discovered, call setStableOrder(true) before any
+   * are added. Removal then shifts the rest of the list down instead, which is O(n) again, but lookups stay O(1).
+   */
   struct IdRegistry {
     std::vector<entityId> ids;
     entNotifyHandler discoverHandler;
@@ -40,6 +48,82 @@ namespace ecs {
     IdRegistry(entNotifyHandler&& discoverHandler = DELEGATE_NOCLASS(doNothing),
                entNotifyHandler&& forgetHandler   = DELEGATE_NOCLASS(doNothing))
                : discoverHandler(discoverHandler), forgetHandler(forgetHandler) { }
+
+    bool has(const entityId& id) const {
+      uint32_t index = entityIndex(id);
+      return index < slots.size() && slots[index] != npos && ids[slots[index]] == id;
+    }
+    void add(const entityId& id) {
+      uint32_t index = entityIndex(id);
+      if (index >= slots.size()) {
+        slots.resize(index + 1, (uint32_t) npos);
+      }
+      slots[index] = (uint32_t) ids.size();
+      ids.push_back(id);
+    }
+    bool remove(const entityId& id) {
+      if (!has(id)) {
+        return false;
+      }
+      uint32_t slot = slots[entityIndex(id)];
+      if (stableOrder) {
+        ids.erase(ids.begin() + slot);
+        for (uint32_t i = slot; i < ids.size(); ++i) {
+          slots[entityIndex(ids[i])] = i;
+        }
+      } else {
+        ids[slot] = ids.back();
+        slots[entityIndex(ids[slot])] = slot;
+        ids.pop_back();
+      }
+      slots[entityIndex(id)] = npos;
+      return true;
+    }
+    void clear() {
+      for (auto id : ids) {
+        slots[entityIndex(id)] = npos;
+      }
+      ids.clear();
+    }
+    /**
+     * Fires the forget handler for every ID in the registry and then removes, all at once, those whose handler
+     * returned true (as forget does one at a time), instead of paying for one removal per ID. Meant for tearing down
+     * lots of entities at a time. The handlers may delete entities or add to and remove from this registry, since
+     * they are fired for a copy of the IDs; an ID removed by an earlier handler is skipped.
+     */
+    void forgetAll() {
+      std::vector<entityId> forgetting(ids);
+      std::vector<entityId> forgotten;
+      for (auto id : forgetting) {
+        if (has(id) && forgetHandler(id)) {
+          forgotten.push_back(id);
+        }
+      }
+      for (auto id : forgotten) {
+        if (has(id)) {
+          slots[entityIndex(id)] = npos;
+        }
+      }
+      // Close the gaps in one pass, keeping the order of the IDs that are left
+      uint32_t kept = 0;
+      for (uint32_t i = 0; i < ids.size(); ++i) {
+        uint32_t index = entityIndex(ids[i]);
+        if (slots[index] != npos) {
+          slots[index] = kept;
+          ids[kept++] = ids[i];
+        }
+      }
+      ids.resize(kept);
+    }
+    void setStableOrder(bool stable) {
+      assert(ids.empty());
+      stableOrder = stable;
+    }
+
+    private:
+      static const uint32_t npos = 0xffffffff;
+      std::vector<uint32_t> slots;
+      bool stableOrder = false;
   };
 
   template<typename Derived_System>
@@ -47,12 +131,24 @@ namespace ecs {
   {
     private:
       bool paused = false;
+      jobs::WorkerPool* workerPool = nullptr;
+      uint32_t grain = JOBS_DEFAULT_GRAIN;
       Derived_System& sys();
 
     protected:
       State* state;
       std::vector<IdRegistry> registries;
 
+      /*
+       * Calls 'fn(const entityId&)' for every ID in 'registry', split into chunks across the worker pool given to
+       * setWorkerPool (or in order on the calling thread if there is none). 'fn' may be called from several threads at
+       * once, so it must only touch the components of the entity it was handed, and must not add or remove components
+       * or entities. Component additions and removals and entity deletions can be recorded in a CommandBuffer per chunk
+       * instead (see ecsCommandBuffer.h), but entities can only be created on the main thread.
+       */
+      template<typename Fn>
+      void parallelFor(IdRegistry& registry, const Fn& fn);
+
     public:
       System(State* state);
       bool init();
@@ -60,7 +156,21 @@ namespace ecs {
       void pause();
       void resume();
       void clean();
+      void forgetAll();
       bool isPaused();
+      /*
+       * The component types the system reads and writes during tick, as declared by the derived system in its
+       * 'readComponents' and 'writeComponents' members. The Scheduler (see ecsScheduler.h) uses these to decide which
+       * systems may run at the same time, so a system must not touch components outside of them while ticking.
+       */
+      compMask getReadComponents();
+      compMask getWriteComponents();
+      /*
+       * Lets the system spread its per-entity loops (those written with parallelFor) across 'pool', 'grain' entities
+       * at a time. Pass a null pool to go back to running them on one thread.
+       */
+      void setWorkerPool(jobs::WorkerPool* pool, uint32_t grain = JOBS_DEFAULT_GRAIN);
+      jobs::WorkerPool* getWorkerPool();
   };
 
   template<typename Derived_System>
@@ -72,16 +182,15 @@ namespace ecs {
   }
   static void discover(const entityId& id, void* data) {
     IdRegistry* registry = reinterpret_cast<IdRegistry*>(data);
-    if (registry->discoverHandler(id)) {
-      registry->ids.push_back(id);
+    if (!registry->has(id) && registry->discoverHandler(id)) {
+      registry->add(id);
     }
   }
   static void forget(const entityId& id, void* data) {
     IdRegistry* registry = reinterpret_cast<IdRegistry*>(data);
-    std::vector<entityId>::iterator position = std::find(registry->ids.begin(), registry->ids.end(), id);
-    if (position != registry->ids.end()) {
+    if (registry->has(id)) {
       if (registry->forgetHandler(id)) {
-        registry->ids.erase(position);
+        registry->remove(id);
       }
     }
   }
@@ -116,14 +225,42 @@ namespace ecs {
   template<typename Derived_System>
   void System<Derived_System>::clean(){
     sys().onClean();
-    for (auto registry : registries) {
-      registry.ids.clear();
+    for (auto& registry : registries) {
+      registry.clear();
+    }
+  }
+  template<typename Derived_System>
+  void System<Derived_System>::forgetAll(){
+    for (auto& registry : registries) {
+      registry.forgetAll();
     }
   }
   template<typename Derived_System>
   bool System<Derived_System>::isPaused(){
     return paused;
   }
+  template<typename Derived_System>
+  compMask System<Derived_System>::getReadComponents(){
+    return sys().readComponents;
+  }
+  template<typename Derived_System>
+  compMask System<Derived_System>::getWriteComponents(){
+    return sys().writeComponents;
+  }
+  template<typename Derived_System>
+  void System<Derived_System>::setWorkerPool(jobs::WorkerPool* pool, uint32_t grain){
+    workerPool = pool;
+    this->grain = grain;
+  }
+  template<typename Derived_System>
+  jobs::WorkerPool* System<Derived_System>::getWorkerPool(){
+    return workerPool;
+  }
+  template<typename Derived_System>
+  template<typename Fn>
+  void System<Derived_System>::parallelFor(IdRegistry& registry, const Fn& fn){
+    jobs::parallelForEach(workerPool, registry.ids, grain, fn);
+  }
 }
 
 #endif //ECS_SYSTEM_H
@@ -20,6 +20,8 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include <algorithm>
+#include <cstring>
 #include "ecsSystem_controls.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -63,12 +65,9 @@ namespace ecs {
       for (auto event : queuedEvents) {
         switch(event.type) {
           case SDL_MOUSEMOTION: {
-            SDL_Window *window = SDL_GetGrabbedWindow();
-            if (SDL_GetGrabbedWindow() != nullptr) {
-              // NOTE: Keep the mouse cursor in the center of the window? Not
-              // necessary, since SDL_SetRelativeMouseMode() does it for us.
-            }
-            if (SDL_GetRelativeMouseMode()) {
+            // NOTE: Keep the mouse cursor in the center of the window? Not
+            // necessary, since SDL_SetRelativeMouseMode() does it for us.
+            if (relativeMouseMode) {
               // Rotate object orientation according to the mouse motion
               // delta
               glm::quat rotation;
@@ -80,6 +79,7 @@ namespace ecs {
                   (float)event.motion.yrel * MOUSE_SENSITIVITY * ((float) M_PI / 180.0f) *
                       (mouseControls->invertedY ? 1.f : -1.f),
                   glm::vec3(1.0f, 0.0f, 0.0f));
+              state->markChanged<Orientation>(id);
             }
             break;
           }
@@ -104,8 +104,7 @@ namespace ecs {
       // zero out acceleration
       wasdControls->accel = glm::vec3();
 
-      // Get current keyboard state and apply actions accordingly
-      const Uint8 *keyStates = SDL_GetKeyboardState(NULL);
+      // Apply actions according to the keyboard state taken before this tick
       #define DO_ON_KEYS(action, ...) if(anyPressed(keyStates, __VA_ARGS__)) { action; }
       DO_ON_KEYS(wasdControls->accel += glm::vec3( 0.0f,  1.0f,  0.0f), SDL_SCANCODE_W, SDL_SCANCODE_UP)
       DO_ON_KEYS(wasdControls->accel += glm::vec3( 0.0f, -1.0f,  0.0f), SDL_SCANCODE_S, SDL_SCANCODE_DOWN)
@@ -142,6 +141,13 @@ namespace ecs {
     queuedEvents.clear();
   }
 
+  void ControlSystem::takeInputSnapshot() {
+    int numKeys;
+    const Uint8 *current = SDL_GetKeyboardState(&numKeys);
+    memcpy(keyStates, current, std::min(numKeys, (int) SDL_NUM_SCANCODES));
+    relativeMouseMode = SDL_GetRelativeMouseMode() == SDL_TRUE;
+  }
+
   bool ControlSystem::handleEvent(SDL_Event &event) {
     switch (event.type) {
       case SDL_MOUSEBUTTONDOWN:
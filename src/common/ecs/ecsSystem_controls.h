@@ -33,12 +33,23 @@ namespace ecs {
           ENUM_Orientation | ENUM_MouseControls,
           ENUM_Orientation | ENUM_WasdControls
       };
+      compMask readComponents = ENUM_MouseControls;
+      compMask writeComponents = ENUM_Orientation | ENUM_WasdControls;
       std::vector<SDL_Event> queuedEvents;
+      // What SDL's input state was when takeInputSnapshot() was last called
+      Uint8 keyStates[SDL_NUM_SCANCODES] = { };
+      bool relativeMouseMode = false;
     public:
       ControlSystem(State* state);
       bool onInit();
       void onTick(float dt);
       bool handleEvent(SDL_Event& event);
+      /*
+       * Copies the keyboard state and mouse mode from SDL for the next tick to use. SDL may only be asked for these on
+       * the main thread, while tick may run on a worker (see Scheduler), so call this on the main thread before every
+       * tick.
+       */
+      void takeInputSnapshot();
   };
 }
 
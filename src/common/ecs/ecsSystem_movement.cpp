@@ -32,12 +32,11 @@ namespace ecs {
     return true;
   }
   void MovementSystem::onTick(float dt) {
-    for (auto id : registries[0].ids) {
-      Scale* scale;
-      state->getScale(id, &scale);
-      ScalarMultFunc* scalarMultFunc;
-      state->getScalarMultFunc(id, &scalarMultFunc);
-      scale->vec = scalarMultFunc->multByFuncOfTime(scale->lastVec, SDL_GetTicks());
-    }
+    uint32_t ticks = SDL_GetTicks();
+    parallelFor(registries[0], [this, ticks](const entityId& id) {
+      Scale* scale = state->getForWrite<Scale>(id);
+      ScalarMultFunc* scalarMultFunc = state->get<ScalarMultFunc>(id);
+      scale->vec = scalarMultFunc->multByFuncOfTime(scale->lastVec, ticks);
+    });
   }
 }
\ No newline at end of file
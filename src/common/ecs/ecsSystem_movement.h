@@ -31,6 +31,8 @@ namespace ecs {
       std::vector<compMask> requiredComponents = {
           ENUM_Scale | ENUM_ScalarMultFunc
       };
+      compMask readComponents = ENUM_ScalarMultFunc;
+      compMask writeComponents = ENUM_Scale;
     public:
       MovementSystem(State* state);
       bool onInit();
@@ -20,22 +20,203 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <unordered_map>
+#include <BulletCollision/NarrowPhaseCollision/btGjkEpa2.h>
+#include "ecsCommandBuffer.h"
 #include "ecsSystem_physics.h"
+#if BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
 
 namespace ecs {
 
-  PhysicsSystem::PhysicsSystem(State *state) : System(state) {
+  static std::atomic<uint64_t> bulletAllocations(0), bulletFrees(0);
+  // Bullet's default allocation functions are malloc and free too, so it doesn't matter which of these a block of
+  // memory allocated before they were installed is given back to
+  static void* countingAlloc(size_t size) {
+    bulletAllocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+  }
+  static void countingFree(void* memory) {
+    if (memory) {
+      bulletFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+    free(memory);
+  }
+
+  /*
+   * Number of queries handed to a worker at a time
+   */
+  #define PHYSICS_QUERY_GRAIN 32
+
+  static inline btVector3 toBt(const glm::vec3& v) { return btVector3(v.x, v.y, v.z); }
+  static inline glm::vec3 toGlm(const btVector3& v) { return glm::vec3(v.getX(), v.getY(), v.getZ()); }
+  static inline entityId entityOf(const btCollisionObject* object) { return (entityId) object->getUserIndex(); }
+  static inline bool isTrigger(const btCollisionObject* object) {
+    return object->getInternalType() == btCollisionObject::CO_GHOST_OBJECT;
+  }
+  static btTransform transformOf(State* state, const entityId& id) {
+    Position* position = state->get<Position>(id);
+    Orientation* orientation = state->get<Orientation>(id);
+    assert(position && orientation); // Physics and Trigger require both, so neither can be removed before them
+    return btTransform(btQuaternion(orientation->quat.x, orientation->quat.y, orientation->quat.z, orientation->quat.w),
+                       btVector3(position->vec.x, position->vec.y, position->vec.z));
+  }
+  static inline bool pairLess(const ContactEvent& left, const ContactEvent& right) {
+    return left.a < right.a || (left.a == right.a && left.b < right.b);
+  }
+  static inline bool samePair(const ContactEvent& left, const ContactEvent& right) {
+    return left.a == right.a && left.b == right.b;
+  }
+
+  /*
+   * Calls 'fn(const btCollisionObject*)' for each object in the broadphase whose bounding box 'overlaps(volume)'.
+   * Walks both of the broadphase's trees (moving and static objects) with a stack kept per thread, so that queries
+   * neither share state nor allocate once each thread has seen its deepest tree. Triggers are left out.
+   */
+  template<typename Overlaps, typename Fn>
+  static void forEachCandidate(btDbvtBroadphase* broadphase, const Overlaps& overlaps, const Fn& fn) {
+    static thread_local std::vector<const btDbvtNode*> stack;
+    for (int set = 0; set < 2; ++set) {
+      if (!broadphase->m_sets[set].m_root) {
+        continue;
+      }
+      stack.clear();
+      stack.push_back(broadphase->m_sets[set].m_root);
+      while (!stack.empty()) {
+        const btDbvtNode* node = stack.back();
+        stack.pop_back();
+        if (!overlaps(node->volume)) {
+          continue;
+        }
+        if (node->isinternal()) {
+          stack.push_back(node->childs[0]);
+          stack.push_back(node->childs[1]);
+        } else {
+          const btBroadphaseProxy* proxy = (const btBroadphaseProxy*) node->data;
+          const btCollisionObject* object = (const btCollisionObject*) proxy->m_clientObject;
+          if (!isTrigger(object)) {
+            fn(object);
+          }
+        }
+      }
+    }
+  }
+
+  /*
+   * Tests a segment from 'from' to 'to' against boxes, each grown by the box from 'boxMin' to 'boxMax' (zero for a
+   * ray, or a swept shape's bounds), the same way btDbvt::rayTestInternal does
+   */
+  struct SegmentVsBox {
+    btVector3 from, inverseDirection, boxMin, boxMax;
+    unsigned int signs[3];
+    btScalar length;
+    SegmentVsBox(const btVector3& from, const btVector3& to, const btVector3& boxMin, const btVector3& boxMax)
+        : from(from), boxMin(boxMin), boxMax(boxMax) {
+      btVector3 direction = to - from;
+      length = direction.length();
+      if (length > SIMD_EPSILON) {
+        direction /= length;
+      }
+      for (int i = 0; i < 3; ++i) {
+        inverseDirection[i] = direction[i] == btScalar(0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1) / direction[i];
+        signs[i] = inverseDirection[i] < btScalar(0);
+      }
+    }
+    bool operator()(const btDbvtVolume& volume) const {
+      btVector3 bounds[2] = { volume.Mins() - boxMax, volume.Maxs() - boxMin };
+      btScalar tmin;
+      return btRayAabb2(from, inverseDirection, signs, bounds, tmin, btScalar(0), length);
+    }
+  };
+
+  static QueryHit noHit() {
+    QueryHit none;
+    none.hit = false;
+    return none;
+  }
 
+  /*
+   * Whether a sphere touches 'shape': exactly for convex shapes (by their signed distance from the centre) and planes,
+   * by parts for compounds, and by bounding box for anything else
+   */
+  static bool sphereTouches(const btVector3& center, btScalar radius, const btCollisionShape* shape,
+                            const btTransform& transform) {
+    if (shape->isConvex()) {
+      btGjkEpaSolver2::sResults results;
+      return btGjkEpaSolver2::SignedDistance(center, btScalar(0), (const btConvexShape*) shape, transform, results)
+             < radius;
+    }
+    if (shape->getShapeType() == STATIC_PLANE_PROXYTYPE) {
+      const btStaticPlaneShape* plane = (const btStaticPlaneShape*) shape;
+      btVector3 normal = transform.getBasis() * plane->getPlaneNormal();
+      btScalar offset = plane->getPlaneConstant() + normal.dot(transform.getOrigin());
+      return normal.dot(center) - offset < radius;
+    }
+    if (shape->isCompound()) {
+      const btCompoundShape* compound = (const btCompoundShape*) shape;
+      for (int i = 0; i < compound->getNumChildShapes(); ++i) {
+        if (sphereTouches(center, radius, compound->getChildShape(i), transform * compound->getChildTransform(i))) {
+          return true;
+        }
+      }
+      return false;
+    }
+    btVector3 aabbMin, aabbMax;
+    shape->getAabb(transform, aabbMin, aabbMax);
+    btVector3 extent(radius, radius, radius);
+    return TestAabbAgainstAabb2(aabbMin, aabbMax, center - extent, center + extent);
+  }
+
+  EcsMotionState::EcsMotionState(State *state, const entityId &id) : state(state), id(id) { }
+  void EcsMotionState::getWorldTransform(btTransform &worldTrans) const {
+    worldTrans = transformOf(state, id);
+  }
+  void EcsMotionState::setWorldTransform(const btTransform &worldTrans) {
+    Position* position = state->getForWrite<Position>(id);
+    Orientation* orientation = state->getForWrite<Orientation>(id);
+    assert(position && orientation);
+    btVector3 currentPos = worldTrans.getOrigin();
+    position->vec = {currentPos.getX(), currentPos.getY(), currentPos.getZ()};
+    btQuaternion currentOr = worldTrans.getRotation();
+    orientation->quat = glm::quat(currentOr.getW(), currentOr.getX(), currentOr.getY(), currentOr.getZ());
+  }
+
+  PhysicsSystem::PhysicsSystem(State *state) : System(state) {
+    btAlignedAllocSetCustom(countingAlloc, countingFree);
   }
   bool PhysicsSystem::onInit() {
     registries[0].discoverHandler = DELEGATE(&PhysicsSystem::onDiscover, this);
     registries[0].forgetHandler = DELEGATE(&PhysicsSystem::onForget, this);
+    registries[1].discoverHandler = DELEGATE(&PhysicsSystem::onDiscoverControlled, this);
+    registries[2].discoverHandler = DELEGATE(&PhysicsSystem::onDiscoverTrigger, this);
+    registries[2].forgetHandler = DELEGATE(&PhysicsSystem::onForgetTrigger, this);
 
     broadphase = new btDbvtBroadphase();
+    ghostPairCallback = new btGhostPairCallback();
+    broadphase->getOverlappingPairCache()->setInternalGhostPairCallback(ghostPairCallback);
     collisionConfiguration = new btDefaultCollisionConfiguration();
-    dispatcher = new btCollisionDispatcher(collisionConfiguration);
-    solver = new btSequentialImpulseConstraintSolver();
-    dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+#if BT_THREADSAFE
+    if (getWorkerPool()) {
+      // Narrowphase, island solving and integration all run on the worker pool given to setWorkerPool
+      taskScheduler = new PhysicsTaskScheduler(getWorkerPool());
+      btSetTaskScheduler(taskScheduler);
+      dispatcher = new btCollisionDispatcherMt(collisionConfiguration);
+      solverPool = new btConstraintSolverPoolMt(taskScheduler->getMaxNumThreads());
+      solver = new btSequentialImpulseConstraintSolverMt(); // used for islands too large to hand to a single thread
+      dynamicsWorld = new btDiscreteDynamicsWorldMt(dispatcher, broadphase, solverPool, solver, collisionConfiguration);
+    } else
+#endif
+    {
+      dispatcher = new btCollisionDispatcher(collisionConfiguration);
+      solver = new btSequentialImpulseConstraintSolver();
+      dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+    }
     dynamicsWorld->setGravity(btVector3(0.0f, 0.0f, -9.81f));
     planeShape = new btStaticPlaneShape(btVector3(0.f, 0.f, 1.f), 0.f);
 
@@ -45,6 +226,7 @@ namespace ecs {
         btVector3(0.f, 0.f, 0.f)));
     btRigidBody::btRigidBodyConstructionInfo groundRigidBodyCI(0, groundMotionState, planeShape, btVector3(0, 0, 0));
     groundRigidBody = new btRigidBody(groundRigidBodyCI);
+    groundRigidBody->setUserIndex(0); // no entity
     groundRigidBody->setRestitution(0.5f);
     groundRigidBody->setFriction(1.f);
     dynamicsWorld->addRigidBody(groundRigidBody);
@@ -53,90 +235,453 @@ namespace ecs {
   }
   void PhysicsSystem::onTick(float dt) {
     for (auto id : registries[1].ids) {
-      WasdControls* wasdControls;
-      state->getWasdControls(id, &wasdControls);
-      Physics* physics;
-      state->getPhysics(id, &physics);
+      WasdControls* wasdControls = state->get<WasdControls>(id);
+      Physics* physics = state->get<Physics>(id);
       physics->rigidBody->applyCentralImpulse({-wasdControls->accel.x, -wasdControls->accel.y, wasdControls->accel.z});
     }
-    dynamicsWorld->stepSimulation(dt); // time step (s), max sub-steps, sub-step length (s)
-    for (auto id : registries[0].ids) {
-      Physics* physics;
-      state->getPhysics(id, &physics);
-      btTransform currentTrans;
-      physics->rigidBody->getMotionState()->getWorldTransform(currentTrans);
-      Position* position;
-      state->getPosition(id, &position);
-      btVector3 currentPos = currentTrans.getOrigin();
-      position->vec = {currentPos.getX(), currentPos.getY(), currentPos.getZ()};
+    syncTriggers();
+    // dt is already a fixed tick (see Game::mainLoop), so take exactly one Bullet step of that length rather than letting
+    // Bullet interpolate motion states on its own
+    // The bodies that moved write their new transforms into their entities as part of the step (see EcsMotionState)
+    dynamicsWorld->stepSimulation(dt, 1, dt); // time step (s), max sub-steps, sub-step length (s)
+    collectContactEvents();
+  }
+  void PhysicsSystem::syncTriggers() {
+    // Only the triggers that were moved (by anything, including their own rigid bodies) since the last sync
+    for (auto id : registries[2].ids) {
+      if (state->changedSince<Position>(id, triggerSyncTick)
+          || state->changedSince<Orientation>(id, triggerSyncTick)) {
+        state->get<Trigger>(id)->ghost->setWorldTransform(transformOf(state, id));
+      }
+    }
+    triggerSyncTick = state->currentTick() - 1; // the systems after this one may still move some this tick
+  }
+  void PhysicsSystem::collectContactEvents() {
+    // Every pair of objects whose bounding boxes overlap has a manifold, but only those with points are touching.
+    // Bullet keeps a point until the two move apart by more than its breaking threshold, so resting contacts don't
+    // flicker between ending and beginning again.
+    manifoldContacts.clear();
+    int numManifolds = dispatcher->getNumManifolds();
+    for (int i = 0; i < numManifolds; ++i) {
+      const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+      int numPoints = manifold->getNumContacts();
+      if (!numPoints) {
+        continue;
+      }
+      ContactEvent contact;
+      contact.a = entityOf(manifold->getBody0());
+      contact.b = entityOf(manifold->getBody1());
+      if (contact.b < contact.a) {
+        std::swap(contact.a, contact.b);
+      }
+      contact.type = ContactEvent::BEGIN;
+      contact.trigger = isTrigger(manifold->getBody0()) || isTrigger(manifold->getBody1());
+      contact.impulse = 0.f;
+      btVector3 point(0.f, 0.f, 0.f);
+      for (int j = 0; j < numPoints; ++j) {
+        const btManifoldPoint& manifoldPoint = manifold->getContactPoint(j);
+        contact.impulse += manifoldPoint.getAppliedImpulse();
+        point += manifoldPoint.getPositionWorldOnB();
+      }
+      contact.point = toGlm(point); // summed for now, and divided once the pair's every manifold is in
+      manifoldContacts.push_back(std::make_pair(contact, (uint32_t) numPoints));
+    }
+    std::sort(manifoldContacts.begin(), manifoldContacts.end(),
+              [](const std::pair<ContactEvent, uint32_t>& left, const std::pair<ContactEvent, uint32_t>& right) {
+                return pairLess(left.first, right.first);
+              });
+    // Two entities can share more than one manifold (one per part of a compound shape), which become one contact
+    // with the total impulse and the mean of all their points
+    contacts.clear();
+    uint32_t pairPoints = 0;
+    for (auto& manifoldContact : manifoldContacts) {
+      if (!contacts.empty() && samePair(contacts.back(), manifoldContact.first)) {
+        contacts.back().impulse += manifoldContact.first.impulse;
+        contacts.back().point += manifoldContact.first.point;
+        pairPoints += manifoldContact.second;
+      } else {
+        if (!contacts.empty()) {
+          contacts.back().point /= (float) pairPoints;
+        }
+        contacts.push_back(manifoldContact.first);
+        pairPoints = manifoldContact.second;
+      }
+    }
+    if (!contacts.empty()) {
+      contacts.back().point /= (float) pairPoints;
+    }
 
-      Orientation* orientation;
-      state->getOrientation(id, &orientation);
-      btQuaternion currentOr = currentTrans.getRotation();
-      orientation->quat = {currentOr.getX(), currentOr.getY(), currentOr.getZ(), currentOr.getW()};
+    // Both lists are sorted, so one walk down them both finds what began, persisted and ended
+    contactEvents.clear();
+    size_t current = 0, last = 0;
+    while (current < contacts.size() || last < lastContacts.size()) {
+      if (last == lastContacts.size()
+          || (current < contacts.size() && pairLess(contacts[current], lastContacts[last]))) {
+        contactEvents.push_back(contacts[current++]);
+      } else if (current == contacts.size() || pairLess(lastContacts[last], contacts[current])) {
+        ContactEvent ended = lastContacts[last++];
+        ended.type = ContactEvent::END;
+        ended.impulse = 0.f;
+        contactEvents.push_back(ended);
+      } else {
+        ContactEvent persisted = contacts[current++];
+        persisted.type = ContactEvent::PERSIST;
+        contactEvents.push_back(persisted);
+        ++last;
+      }
     }
+    lastContacts.swap(contacts);
   }
   void PhysicsSystem::deInit() {
-    for (auto id : registries[0].ids) {
-      state->deleteEntity(id); // onForget will be called for each id
-    }
     //region Delete ground
     dynamicsWorld->removeRigidBody(groundRigidBody);
     delete groundRigidBody;
     delete groundMotionState;
     //endregion
 
-    delete planeShape;
+    // Removing bodies from the world one at a time searches the world's object lists for each one, so instead delete
+    // the world first (which drops every body's broadphase proxy in one pass) and only then free the bodies.
+    std::vector<entityId> physicsIds = registries[0].ids;
     delete dynamicsWorld;
+    dynamicsWorld = nullptr;
+    forgetAll(); // onForget is called for each id, then the registries are emptied all at once
+    for (auto id : physicsIds) {
+      state->deleteEntity(id); // these ids are no longer registered, so this doesn't come back around to onForget
+    }
+
+    delete planeShape;
     delete solver;
     delete dispatcher;
     delete collisionConfiguration;
     delete broadphase;
+    delete ghostPairCallback;
+    contacts.clear();
+    lastContacts.clear();
+    contactEvents.clear();
+#if BT_THREADSAFE
+    if (taskScheduler) {
+      delete solverPool;
+      solverPool = nullptr;
+      btSetTaskScheduler(btGetSequentialTaskScheduler());
+      delete taskScheduler;
+      taskScheduler = nullptr;
+    }
+#endif
   }
   bool PhysicsSystem::onDiscover(const entityId &id) {
-    Position* position;
-    state->getPosition(id, &position);
-    Orientation* orientation;
-    state->getOrientation(id, &orientation);
     Physics* physics;
     state->getPhysics(id, &physics);
+    const SnapshotBody* saved = nullptr;
     switch(physics->geom) {
       case Physics::SPHERE:
-        physics->shape = new btSphereShape(*((float*)physics->geomInitData));
+        physics->shape = shapes.getSphere(*((float*)physics->geomInitData));
         break;
       case Physics::PLANE:
         assert("missing plane collision implementation" == nullptr);
         break;
-      case Physics::MESH: {
-          std::vector<float> *points = (std::vector<float> *) physics->geomInitData;
-          physics->shape = new btConvexHullShape(points->data(), (int) points->size());
-        }
+      case Physics::MESH:
+        physics->shape = shapes.getHull(*((std::vector<float> *) physics->geomInitData));
+        break;
+      case Physics::HULL_FILE:
+        physics->shape = shapes.getHullFile((const char *) physics->geomInitData);
+        break;
+      case Physics::SNAPSHOT:
+        saved = (const SnapshotBody *) physics->geomInitData;
         break;
       default:
         break;
     }
     physics->geomInitData = nullptr;
-    btDefaultMotionState* motionState =
-        new btDefaultMotionState(
-            btTransform(btQuaternion(
-                orientation->quat.x, orientation->quat.y, orientation->quat.z, orientation->quat.w),
-            btVector3(position->vec.x, position->vec.y, position->vec.z)));
+    if (!physics->shape) {
+      return false; // no body is made, and the entity is left out of the system
+    }
+    EcsMotionState* motionState = motionStates.create(state, id);
     btVector3 inertia(0.f, 0.f, 0.f);
-    physics->shape->calculateLocalInertia(physics->mass, inertia);
+    if (saved) {
+      inertia = btVector3(saved->inertia[0], saved->inertia[1], saved->inertia[2]);
+    } else {
+      physics->shape->calculateLocalInertia(physics->mass, inertia);
+    }
     btRigidBody::btRigidBodyConstructionInfo ci(physics->mass, motionState, physics->shape, inertia);
-    physics->rigidBody = new btRigidBody(ci);
+    physics->rigidBody = rigidBodies.create(ci);
+    physics->rigidBody->setUserIndex((int) id); // so that queries can tell which entity they hit
     physics->rigidBody->setRestitution(0.8f);
     physics->rigidBody->setFriction(1.f);
+    if (saved) {
+      physics->rigidBody->setRestitution(saved->restitution);
+      physics->rigidBody->setFriction(saved->friction);
+      physics->rigidBody->setLinearVelocity(
+          btVector3(saved->linearVelocity[0], saved->linearVelocity[1], saved->linearVelocity[2]));
+      physics->rigidBody->setAngularVelocity(
+          btVector3(saved->angularVelocity[0], saved->angularVelocity[1], saved->angularVelocity[2]));
+      physics->rigidBody->setActivationState((int) saved->activationState);
+    }
     dynamicsWorld->addRigidBody(physics->rigidBody);
     return true;
   }
   bool PhysicsSystem::onForget(const entityId &id) {
     Physics* physics;
     state->getPhysics(id, &physics);
-    dynamicsWorld->removeRigidBody(physics->rigidBody);
-    delete physics->rigidBody->getMotionState();
-    delete physics->rigidBody;
-    delete physics->shape;
+    if (dynamicsWorld) {
+      dynamicsWorld->removeRigidBody(physics->rigidBody);
+    }
+    motionStates.destroy((EcsMotionState*) physics->rigidBody->getMotionState());
+    rigidBodies.destroy(physics->rigidBody);
+    physics->rigidBody = nullptr;
+    shapes.release(physics->shape);
+    physics->shape = nullptr;
+    return true;
+  }
+  bool PhysicsSystem::onDiscoverControlled(const entityId &id) {
+    // Only bodies that were made can be pushed around (onDiscover, which comes first, rejects any it couldn't make)
+    return state->get<Physics>(id)->rigidBody != nullptr;
+  }
+  bool PhysicsSystem::onDiscoverTrigger(const entityId &id) {
+    Trigger* trigger;
+    state->getTrigger(id, &trigger);
+    trigger->shape = shapes.getSphere(trigger->radius);
+    trigger->ghost = new btPairCachingGhostObject();
+    trigger->ghost->setCollisionShape(trigger->shape);
+    trigger->ghost->setWorldTransform(transformOf(state, id));
+    trigger->ghost->setCollisionFlags(trigger->ghost->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    trigger->ghost->setUserIndex((int) id);
+    // Triggers have no use for touching the ground, static bodies or each other
+    dynamicsWorld->addCollisionObject(trigger->ghost, btBroadphaseProxy::SensorTrigger, btBroadphaseProxy::AllFilter
+        & ~(btBroadphaseProxy::SensorTrigger | btBroadphaseProxy::StaticFilter));
     return true;
   }
+  bool PhysicsSystem::onForgetTrigger(const entityId &id) {
+    Trigger* trigger;
+    state->getTrigger(id, &trigger);
+    if (dynamicsWorld) {
+      dynamicsWorld->removeCollisionObject(trigger->ghost);
+    }
+    delete trigger->ghost;
+    trigger->ghost = nullptr;
+    shapes.release(trigger->shape);
+    trigger->shape = nullptr;
+    return true;
+  }
+  void PhysicsSystem::raycast(const RayQuery *queries, uint32_t count, QueryHit *hits) {
+    btDbvtBroadphase* broadphase = this->broadphase;
+    jobs::parallelFor(getWorkerPool(), count, PHYSICS_QUERY_GRAIN, [=](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; ++i) {
+        const RayQuery& query = queries[i];
+        btVector3 from = toBt(query.from), to = toBt(query.to);
+        btTransform fromTrans(btQuaternion::getIdentity(), from), toTrans(btQuaternion::getIdentity(), to);
+        btCollisionWorld::ClosestRayResultCallback closest(from, to);
+        forEachCandidate(broadphase, SegmentVsBox(from, to, btVector3(0, 0, 0), btVector3(0, 0, 0)),
+            [&](const btCollisionObject* object) {
+              if (query.ignore && entityOf(object) == query.ignore) {
+                return;
+              }
+              btCollisionWorld::rayTestSingle(fromTrans, toTrans, (btCollisionObject*) object,
+                                              object->getCollisionShape(), object->getWorldTransform(), closest);
+            });
+        if (!closest.hasHit()) {
+          hits[i] = noHit();
+          continue;
+        }
+        hits[i].hit = true;
+        hits[i].id = entityOf(closest.m_collisionObject);
+        hits[i].fraction = closest.m_closestHitFraction;
+        hits[i].point = toGlm(closest.m_hitPointWorld);
+        hits[i].normal = toGlm(closest.m_hitNormalWorld);
+      }
+    });
+  }
+  void PhysicsSystem::sphereSweep(const SweepQuery *queries, uint32_t count, QueryHit *hits) {
+    btDbvtBroadphase* broadphase = this->broadphase;
+    jobs::parallelFor(getWorkerPool(), count, PHYSICS_QUERY_GRAIN, [=](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; ++i) {
+        const SweepQuery& query = queries[i];
+        btVector3 from = toBt(query.from), to = toBt(query.to);
+        btTransform fromTrans(btQuaternion::getIdentity(), from), toTrans(btQuaternion::getIdentity(), to);
+        btSphereShape sphere(query.radius);
+        btCollisionWorld::ClosestConvexResultCallback closest(from, to);
+        btVector3 extent(query.radius, query.radius, query.radius);
+        forEachCandidate(broadphase, SegmentVsBox(from, to, -extent, extent),
+            [&](const btCollisionObject* object) {
+              if (query.ignore && entityOf(object) == query.ignore) {
+                return;
+              }
+              btCollisionWorld::objectQuerySingle(&sphere, fromTrans, toTrans, (btCollisionObject*) object,
+                                                  object->getCollisionShape(), object->getWorldTransform(), closest,
+                                                  btScalar(0));
+            });
+        if (!closest.hasHit()) {
+          hits[i] = noHit();
+          continue;
+        }
+        hits[i].hit = true;
+        hits[i].id = entityOf(closest.m_hitCollisionObject);
+        hits[i].fraction = closest.m_closestHitFraction;
+        hits[i].point = toGlm(closest.m_hitPointWorld);
+        hits[i].normal = toGlm(closest.m_hitNormalWorld);
+      }
+    });
+  }
+  void PhysicsSystem::sphereOverlap(const OverlapQuery *queries, uint32_t count, entityId *ids,
+                                    uint32_t maxIdsPerQuery, uint32_t *idCounts) {
+    btDbvtBroadphase* broadphase = this->broadphase;
+    jobs::parallelFor(getWorkerPool(), count, PHYSICS_QUERY_GRAIN, [=](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; ++i) {
+        const OverlapQuery& query = queries[i];
+        btVector3 center = toBt(query.center);
+        btVector3 extent(query.radius, query.radius, query.radius);
+        btDbvtVolume bounds = btDbvtVolume::FromMM(center - extent, center + extent);
+        entityId* out = ids + (size_t) i * maxIdsPerQuery;
+        uint32_t found = 0;
+        forEachCandidate(broadphase, [&bounds](const btDbvtVolume& volume) { return Intersect(volume, bounds); },
+            [&](const btCollisionObject* object) {
+              if (found == maxIdsPerQuery || (query.ignore && entityOf(object) == query.ignore)) {
+                return;
+              }
+              if (sphereTouches(center, query.radius, object->getCollisionShape(), object->getWorldTransform())) {
+                out[found++] = entityOf(object);
+              }
+            });
+        idCounts[i] = found;
+      }
+    });
+  }
+  bool PhysicsSystem::describeShape(btCollisionShape* shape, SnapshotShape* out) {
+    const std::string& file = shapes.getFile(shape);
+    if (!file.empty()) {
+      out->kind = SnapshotShape::HULL_FILE;
+      out->file = file;
+    } else if (shape->getShapeType() == SPHERE_SHAPE_PROXYTYPE) {
+      out->kind = SnapshotShape::SPHERE;
+      out->radius = ((btSphereShape*) shape)->getRadius();
+    } else if (shape->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE) {
+      btConvexHullShape* hull = (btConvexHullShape*) shape;
+      const btVector3* points = hull->getUnscaledPoints();
+      out->kind = SnapshotShape::HULL;
+      out->points.resize((size_t) hull->getNumPoints() * 3);
+      for (int i = 0; i < hull->getNumPoints(); ++i) {
+        out->points[3 * i] = points[i].getX();
+        out->points[3 * i + 1] = points[i].getY();
+        out->points[3 * i + 2] = points[i].getZ();
+      }
+    } else {
+      return false;
+    }
+    return true;
+  }
+  bool PhysicsSystem::saveSnapshot(const std::string& path) {
+    PhysicsSnapshot snapshot;
+    std::unordered_map<btCollisionShape*, uint32_t> shapeIndices;
+    bool ok = true;
+    for (auto id : registries[0].ids) {
+      Physics* physics = state->get<Physics>(id);
+      auto shapeIndex = shapeIndices.find(physics->shape);
+      if (shapeIndex == shapeIndices.end()) {
+        SnapshotShape shape;
+        if (!describeShape(physics->shape, &shape)) {
+          ok = false; // every shape the cache makes can be described, so this is only a safeguard
+          continue;
+        }
+        shapeIndex = shapeIndices.emplace(physics->shape, (uint32_t) snapshot.shapes.size()).first;
+        snapshot.shapes.push_back(std::move(shape));
+      }
+      btRigidBody* rigidBody = physics->rigidBody;
+      SnapshotBody body;
+      body.id = id;
+      body.shape = shapeIndex->second;
+      body.mass = physics->mass;
+      const btVector3& inverseInertia = rigidBody->getInvInertiaDiagLocal();
+      const btTransform& transform = rigidBody->getWorldTransform();
+      btQuaternion rotation = transform.getRotation();
+      for (int i = 0; i < 3; ++i) {
+        body.inertia[i] = inverseInertia[i] == btScalar(0) ? 0.f : 1.f / inverseInertia[i];
+        body.position[i] = transform.getOrigin()[i];
+        body.linearVelocity[i] = rigidBody->getLinearVelocity()[i];
+        body.angularVelocity[i] = rigidBody->getAngularVelocity()[i];
+      }
+      body.orientation[0] = rotation.getX();
+      body.orientation[1] = rotation.getY();
+      body.orientation[2] = rotation.getZ();
+      body.orientation[3] = rotation.getW();
+      body.friction = rigidBody->getFriction();
+      body.restitution = rigidBody->getRestitution();
+      body.activationState = (uint32_t) rigidBody->getActivationState();
+      snapshot.bodies.push_back(body);
+    }
+    return savePhysicsSnapshot(path, snapshot) && ok;
+  }
+  bool PhysicsSystem::loadSnapshot(const std::string& path, std::vector<std::pair<entityId, entityId>>* ids) {
+    PhysicsSnapshot snapshot;
+    if (!loadPhysicsSnapshot(path, &snapshot)) {
+      return false;
+    }
+    // Each shape is looked up in the cache (or made) once, and every other body using it just counts as another user
+    std::vector<btCollisionShape*> resolved(snapshot.shapes.size(), nullptr);
+    std::vector<bool> missing(snapshot.shapes.size(), false);
+    CommandBuffer commands;
+    std::vector<std::pair<entityId, btCollisionShape*>> made; // every new entity, with the shape it holds a use of
+    bool ok = true;
+    for (auto& body : snapshot.bodies) {
+      btCollisionShape*& shape = resolved[body.shape];
+      if (shape) {
+        shapes.retain(shape);
+      } else if (!missing[body.shape]) {
+        const SnapshotShape& saved = snapshot.shapes[body.shape];
+        switch (saved.kind) {
+          case SnapshotShape::SPHERE:
+            shape = shapes.getSphere(saved.radius);
+            break;
+          case SnapshotShape::HULL:
+            shape = shapes.getHull(saved.points);
+            break;
+          case SnapshotShape::HULL_FILE:
+            shape = shapes.getHullFile(saved.file);
+            break;
+          default:
+            break;
+        }
+        missing[body.shape] = !shape;
+      }
+      if (!shape) {
+        ok = false; // a hull file that is gone; the bodies using it are left out
+        continue;
+      }
+      entityId id;
+      commands.createEntity(*state, &id);
+      commands.add<Position>(id, glm::vec3(body.position[0], body.position[1], body.position[2]));
+      commands.add<Orientation>(id, glm::quat(
+          body.orientation[3], body.orientation[0], body.orientation[1], body.orientation[2]));
+      Physics physics(body.mass, (void*) &body, Physics::SNAPSHOT);
+      physics.shape = shape;
+      commands.add<Physics>(id, physics);
+      made.push_back(std::make_pair(id, shape));
+      if (ids) {
+        ids->push_back(std::make_pair(body.id, id));
+      }
+    }
+    // The snapshot's bodies are read by onDiscover during the flush, so it has to happen before they go away
+    if (commands.flush(*state) != SUCCESS) {
+      ok = false;
+      // The bodies that were never discovered (their Physics couldn't be added) never took over their use of a shape
+      for (auto& entity : made) {
+        if (registries[0].has(entity.first)) {
+          continue;
+        }
+        Physics* physics = state->get<Physics>(entity.first);
+        if (physics) {
+          physics->shape = nullptr;
+        }
+        shapes.release(entity.second);
+      }
+    }
+    return ok;
+  }
+  PhysicsSystem::AllocationStats PhysicsSystem::getAllocationStats() const {
+    AllocationStats stats;
+    stats.rigidBodies = rigidBodies.stats();
+    stats.motionStates = motionStates.stats();
+    stats.sphereShapes = shapes.sphereStats();
+    stats.bulletAllocations = bulletAllocations.load(std::memory_order_relaxed);
+    stats.bulletFrees = bulletFrees.load(std::memory_order_relaxed);
+    return stats;
+  }
 }
@@ -25,22 +25,98 @@
 
 #include "ecsSystem.h"
 #include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include "ecsPhysicsSnapshot.h"
+#include "ecsPhysicsTaskScheduler.h"
+#include "ecsShapeCache.h"
+#include "ecsSlabAllocator.h"
 
 // TODO: figure out how to use bullet to simulate objects without collision components
 namespace ecs {
+  /*
+   * EcsMotionState - the motion state of every physics entity's rigid body. Bullet reads the body's starting transform
+   * from the entity's Position and Orientation, and after each step calls setWorldTransform only for bodies that are
+   * awake, which writes straight back into them (and marks them changed). Sleeping bodies cost nothing.
+   * Bullet may call setWorldTransform for several bodies at once, which is fine since each only touches its own entity.
+   */
+  class EcsMotionState : public btMotionState {
+      State* state;
+      entityId id;
+    public:
+      EcsMotionState(State* state, const entityId& id);
+      virtual void getWorldTransform(btTransform& worldTrans) const;
+      virtual void setWorldTransform(const btTransform& worldTrans);
+  };
+
+  /*
+   * Questions for the physics world, asked in batches (see PhysicsSystem::raycast, sphereSweep and sphereOverlap).
+   * 'ignore' is an entity to leave out of the answer (usually whoever is asking), or 0 for none.
+   */
+  struct RayQuery {
+    glm::vec3 from, to;
+    entityId ignore;
+  };
+  struct SweepQuery {
+    glm::vec3 from, to;
+    float radius;
+    entityId ignore;
+  };
+  struct OverlapQuery {
+    glm::vec3 center;
+    float radius;
+    entityId ignore;
+  };
+  struct QueryHit {
+    bool hit;          // if not, nothing else is set
+    entityId id;       // 0 for the ground
+    float fraction;    // how far along the way from 'from' to 'to' the hit is
+    glm::vec3 point, normal;
+  };
+
+  /*
+   * A change in contact between two entities over the last step (see PhysicsSystem::getContactEvents).
+   * 'a' is always the lower of the two ids (0 for the ground). BEGIN and PERSIST carry the total impulse the solver
+   * applied between the two and the average of their contact points; END carries the point from the step before.
+   * 'trigger' is set when either of the two is a Trigger, which only reports contacts and never pushes back.
+   */
+  struct ContactEvent {
+    enum Type : uint8_t {
+      BEGIN, PERSIST, END
+    };
+    entityId a, b;
+    uint8_t type;
+    bool trigger;
+    float impulse;
+    glm::vec3 point;
+  };
+
   class PhysicsSystem : public System<PhysicsSystem> {
       friend class System;
       std::vector<compMask> requiredComponents = {
           ENUM_Physics,
-          ENUM_Physics | ENUM_WasdControls
+          ENUM_Physics | ENUM_WasdControls,
+          ENUM_Trigger
       };
+      compMask readComponents = ENUM_WasdControls;
+      compMask writeComponents = ENUM_Physics | ENUM_Trigger | ENUM_Position | ENUM_Orientation;
       /* Global physics data structures */
       btDispatcher *dispatcher;
-      btBroadphaseInterface *broadphase;
+      btDbvtBroadphase *broadphase; // queries walk its trees directly
       btConstraintSolver *solver;
       btCollisionConfiguration *collisionConfiguration;
       btDynamicsWorld *dynamicsWorld;
       btCollisionShape* planeShape;
+      ShapeCache shapes; // shared by every entity with the same geometry
+      SlabAllocator<btRigidBody> rigidBodies;
+      SlabAllocator<EcsMotionState> motionStates;
+      btGhostPairCallback* ghostPairCallback; // keeps each trigger's list of overlapping objects up to date
+      uint32_t triggerSyncTick = 0;
+      std::vector<ContactEvent> contacts, lastContacts, contactEvents;
+      std::vector<std::pair<ContactEvent, uint32_t>> manifoldContacts; // with the number of points in each manifold
+#if BT_THREADSAFE
+      PhysicsTaskScheduler* taskScheduler = nullptr;
+      btConstraintSolverPoolMt* solverPool = nullptr;
+#endif
 
       btDefaultMotionState* groundMotionState;
       btRigidBody* groundRigidBody;
@@ -51,6 +127,84 @@ namespace ecs {
       void deInit();
       bool onDiscover(const entityId& id);
       bool onForget(const entityId& id);
+      bool onDiscoverControlled(const entityId& id);
+      bool onDiscoverTrigger(const entityId& id);
+      bool onForgetTrigger(const entityId& id);
+      /*
+       * The Bullet world, for anything that needs to look at it directly (queries, statistics)
+       */
+      btDynamicsWorld* getDynamicsWorld() { return dynamicsWorld; }
+
+      /*
+       * Writes every rigid body, and each distinct shape they use, to a physics snapshot at 'path' (see
+       * ecsPhysicsSnapshot.h). Triggers are not saved.
+       */
+      bool saveSnapshot(const std::string& path);
+      /*
+       * Brings back the bodies saved in the snapshot at 'path', each on a new entity given a Position, an Orientation
+       * and a Physics component, and moving (or asleep) just as it was when saved. Each shape is taken from the cache
+       * once, and each body's inertia comes from the snapshot, so nothing is worked out again. Every component is
+       * added in a single flush of a CommandBuffer. For each body, the pair (entity it was saved from, entity it is now
+       * on) is appended to 'ids' if given, so that the rest of each entity's components can follow.
+       * @return false if the snapshot couldn't be read or any of its bodies couldn't be brought back
+       */
+      bool loadSnapshot(const std::string& path, std::vector<std::pair<entityId, entityId>>* ids = nullptr);
+
+      /*
+       * The contacts that began, persisted or ended during the last step, found in one walk over the dispatcher's
+       * contact manifolds. Sorted by 'a' and then 'b', with one event per pair of entities.
+       */
+      const std::vector<ContactEvent>& getContactEvents() const { return contactEvents; }
+      /*
+       * Calls 'fn(const ContactEvent&)' for each event of the last step in which either entity has every component in
+       * 'mask', in one pass over the events. Entities deleted since then are not matched.
+       */
+      template<typename Fn>
+      void forEachContact(const compMask& mask, Fn fn) {
+        for (const ContactEvent& event : contactEvents) {
+          if (hasComponents(event.a, mask) || hasComponents(event.b, mask)) {
+            fn(event);
+          }
+        }
+      }
+
+      /*
+       * Batched queries. Each answers 'count' queries at once, spread across the worker pool given to setWorkerPool,
+       * and writes the answer to query i into element i of the output array(s), which must have room for them all.
+       * Triggers are never hit. They only read the world, so any number of them can run at once, but never while the
+       * world is being stepped or bodies are being added or removed (run them from a system scheduled after this one,
+       * for instance).
+       */
+      // The closest hit along each ray
+      void raycast(const RayQuery* queries, uint32_t count, QueryHit* hits);
+      // The first thing each sphere would hit moving from 'from' to 'to'
+      void sphereSweep(const SweepQuery* queries, uint32_t count, QueryHit* hits);
+      // The entities touching each sphere: up to 'maxIdsPerQuery' of them go in ids[i * maxIdsPerQuery ...] and how
+      // many there are in idCounts[i]
+      void sphereOverlap(const OverlapQuery* queries, uint32_t count, entityId* ids, uint32_t maxIdsPerQuery,
+                         uint32_t* idCounts);
+
+      /*
+       * Allocation counts, for checking that spawning and despawning bodies at a steady rate doesn't touch the heap.
+       * The bullet counts cover everything Bullet allocates through btAlignedAlloc (broadphase proxies, pair arrays,
+       * contact manifolds beyond its pools, ...) in the whole process, counted from the first PhysicsSystem being made,
+       * so they're only meaningful as differences between two calls.
+       */
+      struct AllocationStats {
+        SlabAllocator<btRigidBody>::Stats rigidBodies;
+        SlabAllocator<EcsMotionState>::Stats motionStates;
+        SlabAllocator<btSphereShape, 64>::Stats sphereShapes;
+        uint64_t bulletAllocations, bulletFrees;
+      };
+      AllocationStats getAllocationStats() const;
+    private:
+      void syncTriggers();
+      void collectContactEvents();
+      bool describeShape(btCollisionShape* shape, SnapshotShape* out);
+      bool hasComponents(const entityId& id, const compMask& mask) {
+        Existence* existence = id ? state->get<Existence>(id) : nullptr;
+        return existence && existence->passesPrerequisitesForAddition(mask);
+      }
   };
 }
 
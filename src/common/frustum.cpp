@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "frustum.h"
+
+namespace ld2016 {
+  Bounds Bounds::transformed(const glm::mat4 &transform) const {
+    Bounds result;
+    // The box around the moved box spans the absolute values of the
+    // transform's axes times the half-extents of the box
+    glm::vec3 boxCenter = glm::vec3(
+        transform * glm::vec4((min + max) * 0.5f, 1.0f));
+    glm::vec3 extents = (max - min) * 0.5f;
+    glm::vec3 movedExtents;
+    for (int row = 0; row < 3; ++row) {
+      movedExtents[row] = fabsf(transform[0][row]) * extents.x
+        + fabsf(transform[1][row]) * extents.y
+        + fabsf(transform[2][row]) * extents.z;
+    }
+    result.min = boxCenter - movedExtents;
+    result.max = boxCenter + movedExtents;
+    // The sphere grows by the longest of the transform's scaled axes
+    float scale = glm::max(glm::length(glm::vec3(transform[0])),
+        glm::max(glm::length(glm::vec3(transform[1])),
+          glm::length(glm::vec3(transform[2]))));
+    result.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+    result.radius = radius * scale;
+    return result;
+  }
+
+  void Bounds::merge(const Bounds &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+    float distance = glm::length(other.center - center);
+    if (distance + other.radius <= radius) {
+      return;  // The other sphere is already inside this one
+    }
+    if (distance + radius <= other.radius) {
+      center = other.center;
+      radius = other.radius;
+      return;
+    }
+    // The smallest sphere touching the far sides of both
+    float merged = (distance + radius + other.radius) * 0.5f;
+    center += (other.center - center) * ((merged - radius) / distance);
+    radius = merged;
+  }
+
+  Frustum::Frustum(const glm::mat4 &viewProjection) {
+    // Each plane is the sum or difference of the last row of the transform
+    // and one of the others (glm matrices are indexed by column first)
+    const glm::mat4 &m = viewProjection;
+    glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+    glm::vec4 planes[6];
+    for (int row = 0; row < 3; ++row) {
+      glm::vec4 r(m[0][row], m[1][row], m[2][row], m[3][row]);
+      planes[row * 2] = w + r;
+      planes[row * 2 + 1] = w - r;
+    }
+    for (int i = 0; i < 8; ++i) {
+      if (i < 6) {
+        // Normalize the planes, so that they give distances for the spheres
+        float length = glm::length(glm::vec3(planes[i]));
+        m_x[i] = planes[i].x / length;
+        m_y[i] = planes[i].y / length;
+        m_z[i] = planes[i].z / length;
+        m_w[i] = planes[i].w / length;
+      } else {
+        m_x[i] = m_y[i] = m_z[i] = 0.0f;
+        m_w[i] = 1.0f;
+      }
+    }
+  }
+
+  bool Frustum::intersectsSphere(const glm::vec3 &center,
+      float radius) const
+  {
+    return !m_outside(center, glm::vec3(), radius);
+  }
+
+  bool Frustum::intersectsBox(const glm::vec3 &min,
+      const glm::vec3 &max) const
+  {
+    return !m_outside((min + max) * 0.5f, (max - min) * 0.5f, 0.0f);
+  }
+
+  /*
+   * Whether there is a plane that the point is further behind than the
+   * radius plus the box's half-extents projected onto the plane's normal
+   */
+  bool Frustum::m_outside(const glm::vec3 &point, const glm::vec3 &extents,
+      float radius) const
+  {
+#ifdef __SSE__
+    __m128 px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y),
+           pz = _mm_set1_ps(point.z);
+    __m128 ex = _mm_set1_ps(extents.x), ey = _mm_set1_ps(extents.y),
+           ez = _mm_set1_ps(extents.z);
+    __m128 r = _mm_set1_ps(radius);
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    for (int i = 0; i < 8; i += 4) {
+      __m128 x = _mm_load_ps(m_x + i), y = _mm_load_ps(m_y + i),
+             z = _mm_load_ps(m_z + i), w = _mm_load_ps(m_w + i);
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x, px), _mm_mul_ps(y, py)),
+          _mm_add_ps(_mm_mul_ps(z, pz), w));
+      __m128 reach = _mm_add_ps(r, _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, x), ex),
+            _mm_mul_ps(_mm_andnot_ps(signMask, y), ey)),
+          _mm_mul_ps(_mm_andnot_ps(signMask, z), ez)));
+      if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, reach),
+              _mm_setzero_ps())))
+      {
+        return true;
+      }
+    }
+    return false;
+#else
+    for (int i = 0; i < 6; ++i) {
+      float distance = m_x[i] * point.x + m_y[i] * point.y
+        + m_z[i] * point.z + m_w[i];
+      float reach = radius + fabsf(m_x[i]) * extents.x
+        + fabsf(m_y[i]) * extents.y + fabsf(m_z[i]) * extents.z;
+      if (distance + reach < 0.0f) {
+        return true;
+      }
+    }
+    return false;
+#endif
+  }
+}
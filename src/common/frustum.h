@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LD2016_COMMON_FRUSTUM_H_
+#define LD2016_COMMON_FRUSTUM_H_
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace ld2016 {
+  /**
+   * A bounding volume given as both an axis-aligned box and a sphere around
+   * the same geometry, so that whichever is tighter can be used.
+   */
+  struct Bounds {
+    glm::vec3 min, max;
+    glm::vec3 center;
+    float radius;
+
+    /**
+     * \return These bounds moved by the given transform, as the box around
+     * the moved box and the sphere around the moved sphere.
+     */
+    Bounds transformed(const glm::mat4 &transform) const;
+
+    /**
+     * Grows these bounds to also hold the given bounds.
+     */
+    void merge(const Bounds &other);
+  };
+
+  /**
+   * How many scene objects the last draw of a scene drew, and how many it
+   * skipped for being outside of the camera's view (see
+   * Scene::cullStats()).
+   */
+  struct CullStats {
+    uint32_t visible, culled;
+  };
+
+  /**
+   * The six planes bounding what a camera can see, for finding which
+   * bounding volumes lie wholly outside of its view.
+   *
+   * The planes are kept as a structure of arrays, padded to eight with
+   * planes that everything is inside, so that each test checks four planes
+   * at a time with SSE (a scalar loop is used where SSE isn't available).
+   */
+  class Frustum {
+    public:
+      /**
+       * Extracts the planes from a combined view-projection transform (a
+       * camera's projection times its world-view transform, to test bounds
+       * in world space).
+       */
+      Frustum(const glm::mat4 &viewProjection);
+
+      /**
+       * \return False if the sphere is wholly outside of the frustum.
+       */
+      bool intersectsSphere(const glm::vec3 &center, float radius) const;
+      /**
+       * \return False if the box is wholly outside of the frustum.
+       */
+      bool intersectsBox(const glm::vec3 &min, const glm::vec3 &max) const;
+      /**
+       * \return False if the bounds are wholly outside of the frustum,
+       * testing the sphere and then the box.
+       */
+      bool intersects(const Bounds &bounds) const {
+        return intersectsSphere(bounds.center, bounds.radius)
+          && intersectsBox(bounds.min, bounds.max);
+      }
+
+    private:
+      // A point p is inside plane i when
+      // m_x[i] * p.x + m_y[i] * p.y + m_z[i] * p.z + m_w[i] >= 0
+      alignas(16) float m_x[8];
+      alignas(16) float m_y[8];
+      alignas(16) float m_z[8];
+      alignas(16) float m_w[8];
+
+      bool m_outside(const glm::vec3 &point, const glm::vec3 &extents,
+          float radius) const;
+  };
+}
+
+#endif
@@ -22,6 +22,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
@@ -34,14 +35,20 @@
 
 #include "game.h"
 
-#define TIME_MULTIPLIER_MS 0.001f
+#define DEFAULT_TICK_RATE 60.0f
+#define DEFAULT_MAX_STEPS_PER_FRAME 5
 
 namespace ld2016 {
   Game::Game(int argc, char **argv, const char *windowTitle)
     : m_windowTitle(windowTitle), m_scene(nullptr),
     m_width(640), m_height(480)
   {
-    m_lastTime = 0.0f;
+    m_lastCounter = 0;
+    m_accumulator = 0.0;
+    m_maxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+    m_reportRenderStats = false;
+    m_lastReportCounter = 0;
+    setTickRate(DEFAULT_TICK_RATE);
 
     if (! m_initSdl() || ! m_initGl() || ! m_initScene()) {
       exit(EXIT_FAILURE);
@@ -115,11 +122,14 @@ namespace ld2016 {
     return true;
   }
 
-  bool Game::mainLoop(ecs::Delegate<bool(SDL_Event &)> &systemsHandler, float &dtOut) {
+  bool Game::mainLoop(ecs::Delegate<bool(SDL_Event &)> &systemsHandler,
+      ecs::Delegate<void(float)> &tickHandler)
+  {
     SDL_GL_SwapWindow(m_window);
-    if (m_lastTime == 0.0f) {
-      // FIXME: Try to make sure this doesn't ever produce a dt of 0.
-      m_lastTime = (float)(std::min((Uint32)0, SDL_GetTicks() - 1)) * TIME_MULTIPLIER_MS;
+    if (m_lastCounter == 0) {
+      // Make the first frame run exactly one tick
+      m_lastCounter = SDL_GetPerformanceCounter();
+      m_accumulator = m_tickDt;
     }
     // Check for SDL events (user input, etc.)
     SDL_Event event;
@@ -149,10 +159,29 @@ namespace ld2016 {
       }
     }
 
-    // Calculate the time since the last frame was drawn
-    float currentTime = (float)SDL_GetTicks() * TIME_MULTIPLIER_MS;
-    float dt = currentTime - m_lastTime;
-    m_lastTime = currentTime;
+    // Add the time since the last frame was drawn to the time owed to the
+    // simulation
+    Uint64 currentCounter = SDL_GetPerformanceCounter();
+    m_accumulator += (double)(currentCounter - m_lastCounter)
+      / (double)SDL_GetPerformanceFrequency();
+    m_lastCounter = currentCounter;
+
+    // Pay it back in fixed ticks, giving up on whatever is left after the
+    // maximum number of them
+    int steps = 0;
+    while (m_accumulator >= m_tickDt) {
+      if (steps == m_maxStepsPerFrame) {
+        m_accumulator = fmod(m_accumulator, (double)m_tickDt);
+        break;
+      }
+      // What the tick is about to change will be drawn interpolated from here
+      state.capturePreviousState();
+      tickHandler(m_tickDt);
+      m_accumulator -= m_tickDt;
+      ++steps;
+    }
+    // How far real time has got between the last tick and the next one
+    float alpha = (float)(m_accumulator / m_tickDt);
 
     // Draw the window
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -162,10 +191,21 @@ namespace ld2016 {
     } else {
       // Draw the scene
       float aspect = (float)m_width / (float)m_height;
-      m_scene->draw(*m_camera, aspect);
+      m_scene->draw(*m_camera, aspect, alpha);
+      if (m_reportRenderStats
+          && currentCounter - m_lastReportCounter >= SDL_GetPerformanceFrequency()) {
+        const RenderQueue::Stats &stats = m_scene->renderStats();
+        fprintf(stderr, "draw calls: %u (%u instanced, of %u instances), shader changes: %u, texture changes: %u, "
+            "mesh changes: %u\n", stats.drawCalls, stats.instancedDrawCalls, stats.instances, stats.shaderChanges,
+            stats.textureChanges, stats.meshChanges);
+        const CullStats &cullStats = m_scene->cullStats();
+        fprintf(stderr, "scene objects visible: %u, culled: %u\n", cullStats.visible, cullStats.culled);
+        m_lastReportCounter = currentCounter;
+      }
     }
+    // Whatever the systems change from here on is newer than what was just drawn (see ecs::BasicState)
+    state.advanceTick();
 
-    dtOut = dt;
     return true;
   }
 }
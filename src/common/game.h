@@ -41,7 +41,12 @@ namespace ld2016 {
       int m_width, m_height;
       Scene *m_scene;
       std::shared_ptr<Camera> m_camera;
-      float m_lastTime;
+      Uint64 m_lastCounter;
+      double m_accumulator;
+      float m_tickDt;
+      int m_maxStepsPerFrame;
+      bool m_reportRenderStats;
+      Uint64 m_lastReportCounter;
 
       bool m_initSdl();
       bool m_initGl();
@@ -60,11 +65,40 @@ namespace ld2016 {
 
       void setCamera(std::shared_ptr<Camera> camera) { m_camera = camera; }
 
+      /**
+       * Sets how many fixed simulation ticks are run per second of real time
+       */
+      void setTickRate(float ticksPerSecond) { m_tickDt = 1.0f / ticksPerSecond; }
+      /**
+       * Sets how many ticks a single frame may run to catch up with real time.
+       * Any time still owed after that many ticks is dropped, so that a slow
+       * frame cannot make the next one slower still.
+       */
+      void setMaxStepsPerFrame(int maxSteps) { m_maxStepsPerFrame = maxSteps; }
+      float tickDt() const { return m_tickDt; }
+
+      /**
+       * Sets whether the draw calls and GL state changes of a frame (see
+       * Scene::renderStats()) are printed to stderr, once a second.
+       */
+      void setReportRenderStats(bool report) { m_reportRenderStats = report; }
+
       virtual bool handleEvent(const SDL_Event &event) {
         return false;
       }
 
-      bool mainLoop(ecs::Delegate<bool(SDL_Event &)> &systemsHandler, float &dtOut);
+      /**
+       * Runs one frame: handles pending events, runs as many fixed ticks
+       * (each of length tickDt()) as the real time elapsed since the last
+       * frame calls for, and draws the scene interpolated between the last
+       * two ticks.
+       *
+       * \param systemsHandler Offered each SDL event before anything else.
+       * \param tickHandler Called once per fixed tick with tickDt().
+       * \return false if the user asked to quit.
+       */
+      bool mainLoop(ecs::Delegate<bool(SDL_Event &)> &systemsHandler,
+          ecs::Delegate<void(float)> &tickHandler);
   };
 }
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef JOBS_PARALLEL_FOR_H
+#define JOBS_PARALLEL_FOR_H
+
+#include <vector>
+#include "jobsWorkerPool.h"
+
+namespace jobs {
+
+  /*
+   * Grain size used when none is given: the number of loop iterations handed to a job at a time. Smaller grains
+   * balance better across threads, larger ones spend less time submitting and stealing jobs.
+   */
+  #define JOBS_DEFAULT_GRAIN 256
+
+  template<typename Fn>
+  struct ParallelForChunk {
+    const Fn* fn;
+    uint32_t begin, end;
+    static void run(void* data) {
+      ParallelForChunk* chunk = reinterpret_cast<ParallelForChunk*>(data);
+      (*chunk->fn)(chunk->begin, chunk->end);
+    }
+  };
+
+  /**
+   * Splits the range [0, count) into chunks of 'grain' iterations and calls 'fn(begin, end)' once per chunk, spread
+   * across the pool's threads. Returns once every chunk is done. The calling thread runs chunks as well, and may be a
+   * job itself (a system being run by the Scheduler, for instance).
+   * If there is only one chunk, or no pool, 'fn' is just called directly.
+   */
+  template<typename Fn>
+  void parallelFor(WorkerPool* pool, uint32_t count, uint32_t grain, const Fn& fn) {
+    if (!grain) {
+      grain = JOBS_DEFAULT_GRAIN;
+    }
+    if (!pool || count <= grain || pool->concurrency() == 1) {
+      if (count) {
+        fn(0u, count);
+      }
+      return;
+    }
+    uint32_t numChunks = (count + grain - 1) / grain;
+    std::vector<ParallelForChunk<Fn>> chunks(numChunks);
+    std::atomic<uint32_t> remaining(numChunks - 1);
+    for (uint32_t i = 1; i < numChunks; ++i) {
+      chunks[i] = { &fn, i * grain, i + 1 == numChunks ? count : (i + 1) * grain };
+      pool->submit({ &ParallelForChunk<Fn>::run, &chunks[i], &remaining });
+    }
+    fn(0u, grain); // the first chunk is kept for this thread rather than submitted
+    pool->waitFor(remaining);
+  }
+
+  /**
+   * Calls 'fn(element)' for every element of 'items' using parallelFor.
+   */
+  template<typename T, typename Fn>
+  void parallelForEach(WorkerPool* pool, std::vector<T>& items, uint32_t grain, const Fn& fn) {
+    T* data = items.data();
+    parallelFor(pool, (uint32_t) items.size(), grain, [data, &fn](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; ++i) {
+        fn(data[i]);
+      }
+    });
+  }
+}
+
+#endif //JOBS_PARALLEL_FOR_H
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "jobsWorkerPool.h"
+
+namespace jobs {
+
+  #ifdef JOBS_SINGLE_THREADED
+
+  WorkerPool::WorkerPool(uint32_t numWorkers) { }
+  WorkerPool::~WorkerPool() { }
+  void WorkerPool::submit(const Job& job) {
+    job.fn(job.data);
+    if (job.counter) {
+      --*job.counter;
+    }
+  }
+  void WorkerPool::wait() { }
+  void WorkerPool::waitFor(const std::atomic<uint32_t>& counter) { }
+  uint32_t WorkerPool::concurrency() const {
+    return 1;
+  }
+  uint32_t WorkerPool::defaultNumWorkers() {
+    return 0;
+  }
+
+  #else
+
+  // Which pool (if any) the current thread is a worker of, and its index in that pool.
+  static thread_local const WorkerPool* workerOf = nullptr;
+  static thread_local int workerIndex = -1;
+
+  WorkerPool::WorkerPool(uint32_t numWorkers) : queued(0), unfinished(0), quitting(false) {
+    for (uint32_t i = 0; i <= numWorkers; ++i) {
+      queues.emplace_back(new Queue);
+    }
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+      workers.emplace_back(&WorkerPool::workerLoop, this, (int) i);
+    }
+  }
+
+  WorkerPool::~WorkerPool() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      quitting = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  int WorkerPool::currentWorker() const {
+    return workerOf == this ? workerIndex : -1;
+  }
+
+  void WorkerPool::submit(const Job& job) {
+    int self = currentWorker();
+    Queue& queue = *queues[self >= 0 ? self : workers.size()];
+    ++unfinished;
+    {
+      // Counted before the job can be seen, so that a thread taking it straight away never takes 'queued' below zero
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      ++queued;
+      queue.jobs.push_back(job);
+    }
+    {
+      // Taking the lock here means no thread can be between checking 'queued' and going to sleep, so none miss this.
+      std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeWorkers.notify_one();
+    wakeWaiters.notify_one();
+  }
+
+  bool WorkerPool::tryTake(int self, Job& job) {
+    if (!queued) {
+      return false;
+    }
+    if (self >= 0) { // own queue, newest first
+      Queue& own = *queues[self];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.jobs.empty()) {
+        job = own.jobs.back();
+        own.jobs.pop_back();
+        --queued;
+        return true;
+      }
+    }
+    uint32_t numQueues = (uint32_t) queues.size();
+    uint32_t start = self >= 0 ? (uint32_t) self + 1 : 0;
+    for (uint32_t i = 0; i < numQueues; ++i) { // then everyone else's (the shared queue included), oldest first
+      uint32_t index = (start + numQueues - 1 - i) % numQueues; // the shared queue (last) comes up first
+      if ((int) index == self) {
+        continue;
+      }
+      Queue& other = *queues[index];
+      std::lock_guard<std::mutex> lock(other.mutex);
+      if (!other.jobs.empty()) {
+        job = other.jobs.front();
+        other.jobs.pop_front();
+        --queued;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void WorkerPool::run(const Job& job) {
+    job.fn(job.data);
+    if (job.counter) {
+      --*job.counter;
+    }
+    if (--unfinished == 0) {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      wakeWaiters.notify_all();
+    }
+  }
+
+  void WorkerPool::wait() {
+    Job job;
+    int self = currentWorker();
+    while (unfinished) {
+      if (tryTake(self, job)) {
+        run(job);
+      } else {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeWaiters.wait(lock, [this] { return unfinished == 0 || queued > 0; });
+      }
+    }
+  }
+
+  void WorkerPool::waitFor(const std::atomic<uint32_t>& counter) {
+    Job job;
+    int self = currentWorker();
+    while (counter) {
+      if (tryTake(self, job)) {
+        run(job);
+      } else {
+        std::this_thread::yield(); // the last few jobs are running elsewhere and will be done soon
+      }
+    }
+  }
+
+  void WorkerPool::workerLoop(int self) {
+    workerOf = this;
+    workerIndex = self;
+    Job job;
+    while (true) {
+      if (tryTake(self, job)) {
+        run(job);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      wakeWorkers.wait(lock, [this] { return quitting || queued > 0; });
+      if (quitting) {
+        return;
+      }
+    }
+  }
+
+  uint32_t WorkerPool::concurrency() const {
+    return (uint32_t) workers.size() + 1;
+  }
+
+  uint32_t WorkerPool::defaultNumWorkers() {
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+  }
+
+  #endif
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef JOBS_WORKER_POOL_H
+#define JOBS_WORKER_POOL_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Emscripten builds without pthread support have no threads to hand work to, so every job is just run right away on
+ * the thread that submits it.
+ */
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define JOBS_SINGLE_THREADED 1
+#endif
+
+#ifndef JOBS_SINGLE_THREADED
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace jobs {
+
+  /**
+   * A unit of work: a function to call and a pointer to hand it.
+   * Whatever 'data' points to must outlive the job. If 'counter' is not null, it is decremented once the job has run
+   * (see WorkerPool::waitFor).
+   */
+  struct Job {
+    void (*fn)(void* data);
+    void* data;
+    std::atomic<uint32_t>* counter;
+  };
+
+  /**
+   * A fixed set of worker threads that run submitted jobs.
+   *
+   * Every worker has its own queue. Jobs submitted from a worker go on the back of that worker's queue, and jobs
+   * submitted from any other thread go on a shared queue. A worker takes jobs from the back of its own queue first
+   * (the most recently submitted, whose data is most likely still in cache), then from the shared queue, and when
+   * both are empty it steals from the front of another worker's queue.
+   *
+   * Threads that call wait() or waitFor() run jobs too while they wait, so a pool of N workers runs up to N + 1 jobs
+   * at once, and a job can safely wait on jobs it submitted itself.
+   */
+  class WorkerPool {
+    public:
+      /**
+       * @param numWorkers number of threads to start, not counting the thread that waits on the pool.
+       *                   Defaults to one less than the number of hardware threads.
+       */
+      explicit WorkerPool(uint32_t numWorkers = defaultNumWorkers());
+      ~WorkerPool();
+      void submit(const Job& job);
+      /**
+       * Runs jobs until every job submitted so far (including any submitted by other jobs meanwhile) has finished.
+       * Must not be called from inside a job, since that job would be waiting on itself. Use waitFor instead.
+       */
+      void wait();
+      /**
+       * Runs jobs until 'counter' reaches zero. Jobs submitted with this counter decrement it when they finish.
+       */
+      void waitFor(const std::atomic<uint32_t>& counter);
+      /**
+       * @return the number of threads that can run jobs at once (workers plus the waiting thread)
+       */
+      uint32_t concurrency() const;
+      static uint32_t defaultNumWorkers();
+
+    private:
+      WorkerPool(const WorkerPool&) = delete;
+      WorkerPool& operator=(const WorkerPool&) = delete;
+      #ifndef JOBS_SINGLE_THREADED
+      struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+      };
+      std::vector<std::unique_ptr<Queue>> queues; // one per worker, then the shared queue last
+      std::vector<std::thread> workers;
+      std::atomic<uint32_t> queued, unfinished;
+      std::atomic<bool> quitting;
+      std::mutex sleepMutex;
+      std::condition_variable wakeWorkers, wakeWaiters;
+
+      int currentWorker() const;
+      bool tryTake(int self, Job& job);
+      void run(const Job& job);
+      void workerLoop(int self);
+      #endif
+  };
+}
+
+#endif //JOBS_WORKER_POOL_H
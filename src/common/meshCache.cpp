@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <cmath>
+#include <cstdio>
+
+#include "glError.h"
+
+#include "meshCache.h"
+
+namespace ld2016 {
+  std::shared_ptr<const MeshBuffers> MeshCache::get(
+      const std::string &meshFile)
+  {
+    std::weak_ptr<const MeshBuffers> &entry = m_meshes()[meshFile];
+    std::shared_ptr<const MeshBuffers> mesh = entry.lock();
+    if (mesh) {
+      return mesh;
+    }
+    MeshBuffers *buffers = new MeshBuffers();
+    if (!m_load(meshFile, buffers)) {
+      delete buffers;
+      m_meshes().erase(meshFile);
+      return nullptr;
+    }
+    // Whoever lets go of the mesh last deletes its buffers and its entry
+    mesh = std::shared_ptr<const MeshBuffers>(buffers,
+        [meshFile](const MeshBuffers *buffers) {
+          glDeleteBuffers(1, &buffers->vertexBuffer);
+          glDeleteBuffers(1, &buffers->indexBuffer);
+          delete buffers;
+          auto found = m_meshes().find(meshFile);
+          if (found != m_meshes().end() && found->second.expired()) {
+            m_meshes().erase(found);
+          }
+        });
+    entry = mesh;
+    return mesh;
+  }
+
+  size_t MeshCache::size() {
+    return m_meshes().size();
+  }
+
+  std::unordered_map<std::string, std::weak_ptr<const MeshBuffers>> &
+  MeshCache::m_meshes() {
+    static std::unordered_map<std::string,
+      std::weak_ptr<const MeshBuffers>> meshes;
+    return meshes;
+  }
+
+  bool MeshCache::m_load(const std::string &meshFile, MeshBuffers *mesh) {
+    Assimp::Importer importer;
+    auto scene = importer.ReadFile(
+        meshFile,
+        aiProcess_Triangulate
+        );
+
+    if (!scene) {
+      fprintf(stderr, "Failed to load mesh from file: '%s'\n",
+          meshFile.c_str());
+      return false;
+    }
+    if (scene->mNumMeshes != 1) {
+      fprintf(stderr, "Mesh file '%s' must contain a single mesh\n",
+          meshFile.c_str());
+      return false;
+    }
+    auto aim = scene->mMeshes[0];
+    if (aim->mNormals == NULL) {
+      fprintf(stderr, "Error: No normals in mesh '%s'\n",
+          meshFile.c_str());
+      return false;
+    }
+    if (!aim->HasTextureCoords(0)) {
+      fprintf(stderr, "Error: No texture coordinates in mesh '%s'\n",
+          meshFile.c_str());
+      return false;
+    }
+
+    // Copy the mesh vertices into a buffer with the appropriate format,
+    // finding the box around them on the way
+    MeshVertex *vertices = new MeshVertex[aim->mNumVertices];
+    glm::vec3 min(INFINITY), max(-INFINITY);
+    for (int i = 0; i < aim->mNumVertices; ++i) {
+      vertices[i].pos[0] = aim->mVertices[i].x;
+      vertices[i].pos[1] = aim->mVertices[i].y;
+      vertices[i].pos[2] = aim->mVertices[i].z;
+      vertices[i].norm[0] = aim->mNormals[i].x;
+      vertices[i].norm[1] = aim->mNormals[i].y;
+      vertices[i].norm[2] = aim->mNormals[i].z;
+      vertices[i].tex[0] = aim->mTextureCoords[0][i].x;
+      vertices[i].tex[1] = aim->mTextureCoords[0][i].y;
+      glm::vec3 pos(vertices[i].pos[0], vertices[i].pos[1],
+          vertices[i].pos[2]);
+      min = glm::min(min, pos);
+      max = glm::max(max, pos);
+    }
+    // The sphere is centered on the box and reaches the furthest vertex
+    mesh->bounds.min = min;
+    mesh->bounds.max = max;
+    mesh->bounds.center = (min + max) * 0.5f;
+    mesh->bounds.radius = 0.0f;
+    for (int i = 0; i < aim->mNumVertices; ++i) {
+      glm::vec3 pos(vertices[i].pos[0], vertices[i].pos[1],
+          vertices[i].pos[2]);
+      mesh->bounds.radius = glm::max(mesh->bounds.radius,
+          glm::length(pos - mesh->bounds.center));
+    }
+    // Copy the vertices buffer to the GL
+    glGenBuffers(1, &mesh->vertexBuffer);
+    FORCE_ASSERT_GL_ERROR();
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+    FORCE_ASSERT_GL_ERROR();
+    glBufferData(
+        GL_ARRAY_BUFFER,  // target
+        sizeof(MeshVertex) * aim->mNumVertices,  // size
+        vertices,  // data
+        GL_STATIC_DRAW  // usage
+        );
+    FORCE_ASSERT_GL_ERROR();
+    delete[] vertices;
+    // Copy the face data into an index buffer
+    uint32_t *indices = new uint32_t[3 * aim->mNumFaces];
+    for (int i = 0; i < aim->mNumFaces; ++i) {
+      assert(aim->mFaces[i].mNumIndices == 3);
+      indices[i * 3] = aim->mFaces[i].mIndices[0];
+      indices[i * 3 + 1] = aim->mFaces[i].mIndices[1];
+      indices[i * 3 + 2] = aim->mFaces[i].mIndices[2];
+    }
+    // Copy the index data to the GL
+    glGenBuffers(1, &mesh->indexBuffer);
+    FORCE_ASSERT_GL_ERROR();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+    FORCE_ASSERT_GL_ERROR();
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,  // target
+        sizeof(uint32_t) * 3 * aim->mNumFaces,  // size
+        indices,  // data
+        GL_STATIC_DRAW  // usage
+        );
+    FORCE_ASSERT_GL_ERROR();
+    delete[] indices;
+    mesh->numIndices = aim->mNumFaces * 3;
+    return true;
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LD2016_COMMON_MESH_CACHE_H_
+#define LD2016_COMMON_MESH_CACHE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "renderQueue.h"
+
+namespace ld2016 {
+  /**
+   * Loads each mesh file once and shares its GL buffers among everything
+   * that draws it, so that spawning another copy of an object costs neither
+   * an import nor an upload.
+   *
+   * Meshes are handed out as shared pointers: the buffers of a mesh are
+   * deleted as soon as its last user lets go of it, and the file is loaded
+   * again if it is ever asked for after that. Like the rest of the GL
+   * resources, meshes may only be asked for and released on the thread that
+   * owns the GL context.
+   */
+  class MeshCache {
+    public:
+      /**
+       * \param meshFile Path to a mesh file holding a single mesh with
+       * normals and texture coordinates.
+       * \return The mesh loaded from the given file, shared with every other
+       * user of the same path, or null if the file couldn't be loaded.
+       */
+      static std::shared_ptr<const MeshBuffers> get(const std::string &meshFile);
+
+      /**
+       * \return The number of meshes currently loaded.
+       */
+      static size_t size();
+
+    private:
+      static std::unordered_map<std::string,
+        std::weak_ptr<const MeshBuffers>> &m_meshes();
+      static bool m_load(const std::string &meshFile, MeshBuffers *mesh);
+  };
+}
+
+#endif
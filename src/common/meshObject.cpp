@@ -22,14 +22,8 @@
  * IN THE SOFTWARE.
  */
 
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
-#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include "stb_image.h"
 
-#include "glError.h"
 #include "shaderProgram.h"
 #include "shaders.h"
 
@@ -48,237 +42,37 @@ namespace ld2016 {
     status = this->state->addScale(id, scale);
     assert(status == ecs::SUCCESS);
 
-    // Load the mesh from file using assimp
-    m_loadMesh(meshFile);
-    // Load the texture from file using SDL2
-    m_loadTexture(textureFile);
+    // The files are only loaded by the first MeshObject to use them
+    m_mesh = MeshCache::get(meshFile);
+    m_texture = TextureCache::get(textureFile);
   }
 
   MeshObject::~MeshObject() {
   }
 
-  void MeshObject::m_loadMesh(const std::string &meshFile) {
-    Assimp::Importer importer;
-    auto scene = importer.ReadFile(
-        meshFile,
-        aiProcess_Triangulate
-        );
-
-    if (!scene) {
-      fprintf(stderr, "Failed to load mesh from file: '%s'\n",
-          meshFile.c_str());
-    }
-    if (scene->mNumMeshes != 1) {
-      fprintf(stderr, "Mesh file '%s' must contain a single mesh",
-          meshFile.c_str());
-    }
-    auto aim = scene->mMeshes[0];
-    if (aim->mNormals == NULL) {
-      fprintf(stderr, "Error: No normals in mesh '%s'\n",
-          meshFile.c_str());
-    }
-    if (!aim->HasTextureCoords(0)) {
-      fprintf(stderr, "Error: No texture coordinates in mesh '%s'\n",
-          meshFile.c_str());
-    }
-
-    // Copy the mesh vertices into a buffer with the appropriate format
-    MeshVertex *vertices = new MeshVertex[aim->mNumVertices];
-    for (int i = 0; i < aim->mNumVertices; ++i) {
-      vertices[i].pos[0] = aim->mVertices[i].x;
-      vertices[i].pos[1] = aim->mVertices[i].y;
-      vertices[i].pos[2] = aim->mVertices[i].z;
-      vertices[i].norm[0] = aim->mNormals[i].x;
-      vertices[i].norm[1] = aim->mNormals[i].y;
-      vertices[i].norm[2] = aim->mNormals[i].z;
-      vertices[i].tex[0] = aim->mTextureCoords[0][i].x;
-      vertices[i].tex[1] = aim->mTextureCoords[0][i].y;
-      /*fprintf(stderr,
-          "vertices[%d]:\n"
-          "  pos: (%g, %g, %g)\n"
-          "  norm: (%g, %g, %g)\n"
-          "  tex: (%g, %g)\n",
-          i,
-          vertices[i].pos[0],
-          vertices[i].pos[1],
-          vertices[i].pos[2],
-          vertices[i].norm[0],
-          vertices[i].norm[1],
-          vertices[i].norm[2],
-          vertices[i].tex[0],
-          vertices[i].tex[1]);*/
-    }
-    // Copy the vertices buffer to the GL
-    glGenBuffers(1, &m_vertexBuffer);
-    FORCE_ASSERT_GL_ERROR();
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    FORCE_ASSERT_GL_ERROR();
-    glBufferData(
-        GL_ARRAY_BUFFER,  // target
-        sizeof(MeshVertex) * aim->mNumVertices,  // size
-        vertices,  // data
-        GL_STATIC_DRAW  // usage
-        );
-    FORCE_ASSERT_GL_ERROR();
-    delete[] vertices;
-    // Copy the face data into an index buffer
-    uint32_t *indices = new uint32_t[3 * aim->mNumFaces];
-    for (int i = 0; i < aim->mNumFaces; ++i) {
-      assert(aim->mFaces[i].mNumIndices == 3);
-      indices[i * 3] = aim->mFaces[i].mIndices[0];
-      indices[i * 3 + 1] = aim->mFaces[i].mIndices[1];
-      indices[i * 3 + 2] = aim->mFaces[i].mIndices[2];
+  void MeshObject::enqueue(RenderQueue &queue, const glm::mat4 &modelWorld,
+      const glm::mat4 &worldView, float alpha)
+  {
+    if (!m_mesh) {
+      return;
     }
-    // Copy the index data to the GL
-    glGenBuffers(1, &m_indexBuffer);
-    FORCE_ASSERT_GL_ERROR();
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-    FORCE_ASSERT_GL_ERROR();
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,  // target
-        sizeof(uint32_t) * 3 * aim->mNumFaces,  // size
-        indices,  // data
-        GL_STATIC_DRAW  // usage
-        );
-    FORCE_ASSERT_GL_ERROR();
-    delete[] indices;
-    m_numIndices = aim->mNumFaces * 3;
+    ecs::Scale* scale;
+    state->getScale(id, &scale);
+    glm::mat4 modelView = worldView * modelWorld * glm::scale(glm::mat4(), scale->vec);
+    // Use a simple shader, or its instanced twin when drawn with others like it
+    queue.push(Shaders::textureShader().get(), m_texture ? m_texture->texture : 0, m_mesh.get(), modelView,
+               Shaders::textureInstancedShader().get());
   }
 
-  void MeshObject::m_loadTexture(const std::string &textureFile) {
-    int x, y, n;
-    stbi_set_flip_vertically_on_load(true);
-    uint8_t* data = stbi_load(textureFile.c_str(), &x, &y, &n, 0);
-    if (!data) {
-      fprintf(stderr, "Failed to load texture file '%s'.\n", textureFile.c_str());
+  Extent MeshObject::bounds(Bounds *bounds) const {
+    if (!m_mesh) {
+      return EXTENT_NOTHING;
     }
-    // Create the texture object in the GL
-    glGenTextures(1, &m_texture);
-    FORCE_ASSERT_GL_ERROR();
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    FORCE_ASSERT_GL_ERROR();
-    // Copy the image to the GL
-    glTexImage2D(
-        GL_TEXTURE_2D,  // target
-        0,  // level
-        GL_RGBA,  // internal format
-        x,  // width
-        y,  // height
-        0,  // border
-        GL_RGBA,  // format
-        GL_UNSIGNED_BYTE,  // type
-        data  // data
-        );
-    FORCE_ASSERT_GL_ERROR();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    FORCE_ASSERT_GL_ERROR();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    FORCE_ASSERT_GL_ERROR();
-    stbi_image_free(data);
-  }
-
-  void MeshObject::m_drawSurface(
-      const glm::mat4 &modelView,
-      const glm::mat4 &projection)
-  {
-    // Use a simple shader
-    auto shader = Shaders::textureShader();
-    shader->use();
-
-    // Prepare the uniform values
-    assert(shader->modelViewLocation() != -1);
-    glUniformMatrix4fv(
-        shader->modelViewLocation(),  // location
-        1,  // count
-        0,  // transpose
-        glm::value_ptr(modelView)  // value
-        );
-    ASSERT_GL_ERROR();
-    assert(shader->projectionLocation() != -1);
-    glUniformMatrix4fv(
-        shader->projectionLocation(),  // location
-        1,  // count
-        0,  // transpose
-        glm::value_ptr(projection)  // value
-        );
-    ASSERT_GL_ERROR();
-
-    /*
-    // Prepare the texture sampler
-    assert(shader->texture0() != -1);
-    glUniform1i(
-        shader->texture0(),  // location
-        0  // value
-        );
-    ASSERT_GL_ERROR();
-    glActiveTexture(GL_TEXTURE0);
-    ASSERT_GL_ERROR();
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    ASSERT_GL_ERROR();
-    */
-
-    // Prepare the vertex attributes
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    ASSERT_GL_ERROR();
-    assert(shader->vertPositionLocation() != -1);
-    glEnableVertexAttribArray(shader->vertPositionLocation());
-    ASSERT_GL_ERROR();
-    glVertexAttribPointer(
-        shader->vertPositionLocation(),  // index
-        3,  // size
-        GL_FLOAT,  // type
-        0,  // normalized
-        sizeof(MeshVertex),  // stride
-        &(((MeshVertex *)0)->pos[0])  // pointer
-        );
-    ASSERT_GL_ERROR();
-    /*
-    assert(shader->vertNormalLocation() != -1);
-    glEnableVertexAttribArray(shader->vertNormalLocation());
-    ASSERT_GL_ERROR();
-    glVertexAttribPointer(
-        shader->vertNormalLocation(),  // index
-        3,  // size
-        GL_FLOAT,  // type
-        0,  // normalized
-        sizeof(MeshVertex),  // stride
-        &(((MeshVertex *)0)->norm[0])  // pointer
-        );
-    ASSERT_GL_ERROR();
-    */
-    assert(shader->vertTexCoordLocation() != -1);
-    glEnableVertexAttribArray(shader->vertTexCoordLocation());
-    ASSERT_GL_ERROR();
-    glVertexAttribPointer(
-        shader->vertTexCoordLocation(),  // index
-        2,  // size
-        GL_FLOAT,  // type
-        0,  // normalized
-        sizeof(MeshVertex),  // stride
-        &(((MeshVertex *)0)->tex[0])  // pointer
-        );
-    ASSERT_GL_ERROR();
-
-    // Draw the surface
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    ASSERT_GL_ERROR();
-    glDrawElements(
-        GL_TRIANGLES,  // mode
-        m_numIndices,  // count
-        GL_UNSIGNED_INT,  // type
-        0  // indices
-        );
-    ASSERT_GL_ERROR();
-  }
-
-  void MeshObject::draw(const glm::mat4 &modelWorld,
-      const glm::mat4 &worldView, const glm::mat4 &projection,
-      float alpha, bool debug)
-  {
     ecs::Scale* scale;
     state->getScale(id, &scale);
-    glm::mat4 modelView = worldView * modelWorld * glm::scale(glm::mat4(), scale->vec);
-    m_drawSurface(modelView, projection);
+    // The mesh is scaled before it is drawn (see enqueue())
+    glm::mat4 scaled = glm::scale(glm::mat4(), scale->vec);
+    *bounds = m_mesh->bounds.transformed(scaled);
+    return EXTENT_BOUNDED;
   }
 }
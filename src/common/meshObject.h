@@ -24,30 +24,19 @@
 #ifndef LD2016_COMMON_MESH_OBJECT_H_
 #define LD2016_COMMON_MESH_OBJECT_H_
 
-#include <GL/glew.h>
+#include <memory>
 #include <string>
 
+#include "meshCache.h"
 #include "sceneObject.h"
+#include "textureCache.h"
 
 namespace ld2016 {
   class MeshObject : public SceneObject {
     private:
-      typedef struct {
-        float pos[3];
-        float norm[3];
-        float tex[2];
-      } MeshVertex;
-
-      std::string m_meshFile;
-      GLuint m_vertexBuffer, m_indexBuffer, m_texture;
-      int m_numIndices;
-
-      void m_loadMesh(const std::string &meshFile);
-      void m_loadTexture(const std::string &textureFile);
-
-      void m_drawSurface(
-          const glm::mat4 &modelView,
-          const glm::mat4 &projection);
+      // Shared with every other MeshObject made from the same files
+      std::shared_ptr<const MeshBuffers> m_mesh;
+      std::shared_ptr<const Texture> m_texture;
     public:
       MeshObject(ecs::State &state, const std::string &meshFile, const std::string &textureFile,
                  const glm::vec3 &position = glm::vec3(),
@@ -55,9 +44,9 @@ namespace ld2016 {
                  const glm::vec3 &scale = {1.f, 1.f, 1.f});
       virtual ~MeshObject();
 
-      virtual void draw(const glm::mat4 &modelWorld,
-          const glm::mat4 &worldView, const glm::mat4 &projection,
-          float alpha, bool debug);
+      virtual void enqueue(RenderQueue &queue, const glm::mat4 &modelWorld,
+          const glm::mat4 &worldView, float alpha);
+      virtual Extent bounds(Bounds *bounds) const;
   };
 }
 
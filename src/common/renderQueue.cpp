@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+#ifdef __EMSCRIPTEN__
+#define GL_GLEXT_PROTOTYPES
+#include <GLES2/gl2ext.h>
+#endif
+
+#include "glError.h"
+#include "shaderProgram.h"
+
+#include "renderQueue.h"
+
+namespace ld2016 {
+  /*
+   * Bits of the sort key given to each piece of state. GL names are small
+   * integers handed out in order, so they fit; if one ever doesn't, draws
+   * are only grouped less well, since submit() compares the state itself.
+   */
+  #define RENDER_KEY_SHADER_SHIFT 48
+  #define RENDER_KEY_TEXTURE_SHIFT 24
+  #define RENDER_KEY_TEXTURE_MASK 0xffffffull
+  #define RENDER_KEY_MESH_MASK 0xffffffull
+
+  /*
+   * The fewest draws worth making as one instanced draw call, below which
+   * streaming their matrices costs more than it saves
+   */
+  #define RENDER_QUEUE_MIN_INSTANCES 4
+
+  /*
+   * The instanced draw entry points differ by GL: the ANGLE extension under
+   * WebGL, and either the ARB extension or GL 3.3 (where they are core)
+   * elsewhere
+   */
+  enum InstancingApi {
+    INSTANCING_UNKNOWN, INSTANCING_NONE, INSTANCING_ANGLE, INSTANCING_ARB,
+    INSTANCING_CORE
+  };
+  static InstancingApi instancingApi() {
+    static InstancingApi api = INSTANCING_UNKNOWN;
+    if (api == INSTANCING_UNKNOWN) {
+#ifdef __EMSCRIPTEN__
+      const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+      api = extensions && strstr(extensions, "ANGLE_instanced_arrays")
+          ? INSTANCING_ANGLE : INSTANCING_NONE;
+#else
+      api = GLEW_ARB_instanced_arrays ? INSTANCING_ARB
+          : GLEW_VERSION_3_3 ? INSTANCING_CORE : INSTANCING_NONE;
+#endif
+    }
+    return api;
+  }
+  static void vertexAttribDivisor(GLuint index, GLuint divisor) {
+#ifdef __EMSCRIPTEN__
+    glVertexAttribDivisorANGLE(index, divisor);
+#else
+    if (instancingApi() == INSTANCING_ARB) {
+      glVertexAttribDivisorARB(index, divisor);
+    } else {
+      glVertexAttribDivisor(index, divisor);
+    }
+#endif
+  }
+  static void drawElementsInstanced(GLsizei count, GLsizei instances) {
+#ifdef __EMSCRIPTEN__
+    glDrawElementsInstancedANGLE(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0,
+        instances);
+#else
+    if (instancingApi() == INSTANCING_ARB) {
+      glDrawElementsInstancedARB(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0,
+          instances);
+    } else {
+      glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0,
+          instances);
+    }
+#endif
+  }
+
+  RenderQueue::RenderQueue()
+    : m_stats(), m_instancing(false), m_instanceBuffer(0), m_shader(nullptr),
+    m_mesh(nullptr), m_texture(0), m_textureBound(false)
+  {
+  }
+
+  RenderQueue::~RenderQueue() {
+    if (m_instanceBuffer) {
+      glDeleteBuffers(1, &m_instanceBuffer);
+    }
+  }
+
+  bool RenderQueue::instancingSupported() {
+    return instancingApi() != INSTANCING_NONE;
+  }
+
+  void RenderQueue::push(const ShaderProgram *shader, GLuint texture,
+      const MeshBuffers *mesh, const glm::mat4 &modelView,
+      const ShaderProgram *instancedShader)
+  {
+    uint64_t key = (uint64_t) shader->program() << RENDER_KEY_SHADER_SHIFT
+        | ((uint64_t) texture & RENDER_KEY_TEXTURE_MASK) << RENDER_KEY_TEXTURE_SHIFT
+        | ((uint64_t) mesh->vertexBuffer & RENDER_KEY_MESH_MASK);
+    m_order.push_back(std::make_pair(key, (uint32_t) m_items.size()));
+    m_items.push_back({ shader, mesh, texture, modelView, instancedShader });
+  }
+
+  void RenderQueue::submit(const glm::mat4 &projection) {
+    m_stats = Stats();
+    std::sort(m_order.begin(), m_order.end());
+
+    m_shader = nullptr;
+    m_mesh = nullptr;
+    m_textureBound = false;
+    bool instancing = m_instancing && instancingSupported();
+    size_t next = 0;
+    while (next < m_order.size()) {
+      // Draws that can be batched together are next to each other, since
+      // they have the same key
+      const DrawItem &first = m_items[m_order[next].second];
+      size_t run = 1;
+      while (instancing && first.instancedShader
+          && next + run < m_order.size()) {
+        const DrawItem &item = m_items[m_order[next + run].second];
+        if (item.shader != first.shader || item.texture != first.texture
+            || item.mesh != first.mesh
+            || item.instancedShader != first.instancedShader) {
+          break;
+        }
+        ++run;
+      }
+      if (run >= RENDER_QUEUE_MIN_INSTANCES) {
+        m_drawInstanced(next, run, projection);
+      } else {
+        for (size_t i = next; i < next + run; ++i) {
+          m_draw(m_items[m_order[i].second], projection);
+        }
+      }
+      next += run;
+    }
+
+    m_items.clear();
+    m_order.clear();
+  }
+
+  void RenderQueue::m_draw(const DrawItem &item, const glm::mat4 &projection) {
+    m_setState(item.shader, item.texture, item.mesh, projection);
+    assert(m_shader->modelViewLocation() != -1);
+    glUniformMatrix4fv(
+        m_shader->modelViewLocation(),  // location
+        1,  // count
+        0,  // transpose
+        glm::value_ptr(item.modelView)  // value
+        );
+    ASSERT_GL_ERROR();
+    glDrawElements(
+        GL_TRIANGLES,  // mode
+        m_mesh->numIndices,  // count
+        GL_UNSIGNED_INT,  // type
+        0  // indices
+        );
+    ASSERT_GL_ERROR();
+    ++m_stats.drawCalls;
+  }
+
+  void RenderQueue::m_drawInstanced(size_t first, size_t count,
+      const glm::mat4 &projection)
+  {
+    const DrawItem &batch = m_items[m_order[first].second];
+    m_setState(batch.instancedShader, batch.texture, batch.mesh, projection);
+
+    // Stream this batch's matrices into a fresh buffer store, so that the GL
+    // needn't wait on the draws still reading the last one
+    m_instanceModelViews.clear();
+    for (size_t i = first; i < first + count; ++i) {
+      m_instanceModelViews.push_back(m_items[m_order[i].second].modelView);
+    }
+    if (!m_instanceBuffer) {
+      glGenBuffers(1, &m_instanceBuffer);
+      FORCE_ASSERT_GL_ERROR();
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    ASSERT_GL_ERROR();
+    glBufferData(
+        GL_ARRAY_BUFFER,  // target
+        sizeof(glm::mat4) * m_instanceModelViews.size(),  // size
+        m_instanceModelViews.data(),  // data
+        GL_STREAM_DRAW  // usage
+        );
+    ASSERT_GL_ERROR();
+
+    // A matrix attribute takes one location per column
+    GLint location = m_shader->instanceModelViewLocation();
+    assert(location != -1);
+    for (GLuint column = 0; column < 4; ++column) {
+      glEnableVertexAttribArray(location + column);
+      ASSERT_GL_ERROR();
+      glVertexAttribPointer(
+          location + column,  // index
+          4,  // size
+          GL_FLOAT,  // type
+          0,  // normalized
+          sizeof(glm::mat4),  // stride
+          (const GLvoid *)(sizeof(glm::vec4) * column)  // pointer
+          );
+      ASSERT_GL_ERROR();
+      vertexAttribDivisor(location + column, 1);
+      ASSERT_GL_ERROR();
+    }
+    drawElementsInstanced(m_mesh->numIndices, (GLsizei) count);
+    ASSERT_GL_ERROR();
+    // Leave these locations as any other shader expects to find them
+    for (GLuint column = 0; column < 4; ++column) {
+      vertexAttribDivisor(location + column, 0);
+      glDisableVertexAttribArray(location + column);
+    }
+    ASSERT_GL_ERROR();
+
+    ++m_stats.drawCalls;
+    ++m_stats.instancedDrawCalls;
+    m_stats.instances += (uint32_t) count;
+  }
+
+  void RenderQueue::m_setState(const ShaderProgram *shader, GLuint texture,
+      const MeshBuffers *mesh, const glm::mat4 &projection)
+  {
+    if (shader != m_shader) {
+      m_shader = shader;
+      shader->use();
+      assert(shader->projectionLocation() != -1);
+      glUniformMatrix4fv(
+          shader->projectionLocation(),  // location
+          1,  // count
+          0,  // transpose
+          glm::value_ptr(projection)  // value
+          );
+      ASSERT_GL_ERROR();
+      assert(shader->vertPositionLocation() != -1);
+      glEnableVertexAttribArray(shader->vertPositionLocation());
+      ASSERT_GL_ERROR();
+      if (shader->vertNormalLocation() != -1) {
+        glEnableVertexAttribArray(shader->vertNormalLocation());
+        ASSERT_GL_ERROR();
+      }
+      if (shader->vertTexCoordLocation() != -1) {
+        glEnableVertexAttribArray(shader->vertTexCoordLocation());
+        ASSERT_GL_ERROR();
+      }
+      ++m_stats.shaderChanges;
+      // The new shader's attribute locations may differ
+      m_mesh = nullptr;
+    }
+    if (!m_textureBound || texture != m_texture) {
+      m_texture = texture;
+      m_textureBound = true;
+      glBindTexture(GL_TEXTURE_2D, texture);
+      ASSERT_GL_ERROR();
+      ++m_stats.textureChanges;
+    }
+    if (mesh != m_mesh) {
+      m_mesh = mesh;
+      glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+      ASSERT_GL_ERROR();
+      glVertexAttribPointer(
+          shader->vertPositionLocation(),  // index
+          3,  // size
+          GL_FLOAT,  // type
+          0,  // normalized
+          sizeof(MeshVertex),  // stride
+          &(((MeshVertex *)0)->pos[0])  // pointer
+          );
+      ASSERT_GL_ERROR();
+      if (shader->vertNormalLocation() != -1) {
+        glVertexAttribPointer(
+            shader->vertNormalLocation(),  // index
+            3,  // size
+            GL_FLOAT,  // type
+            0,  // normalized
+            sizeof(MeshVertex),  // stride
+            &(((MeshVertex *)0)->norm[0])  // pointer
+            );
+        ASSERT_GL_ERROR();
+      }
+      if (shader->vertTexCoordLocation() != -1) {
+        glVertexAttribPointer(
+            shader->vertTexCoordLocation(),  // index
+            2,  // size
+            GL_FLOAT,  // type
+            0,  // normalized
+            sizeof(MeshVertex),  // stride
+            &(((MeshVertex *)0)->tex[0])  // pointer
+            );
+        ASSERT_GL_ERROR();
+      }
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+      ASSERT_GL_ERROR();
+      ++m_stats.meshChanges;
+    }
+  }
+}
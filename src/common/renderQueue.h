@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LD2016_COMMON_RENDER_QUEUE_H_
+#define LD2016_COMMON_RENDER_QUEUE_H_
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+#include "frustum.h"
+
+namespace ld2016 {
+  class ShaderProgram;
+
+  /**
+   * The vertex layout of every mesh drawn through a RenderQueue.
+   */
+  struct MeshVertex {
+    float pos[3];
+    float norm[3];
+    float tex[2];
+  };
+
+  /**
+   * The GL buffers holding a mesh: MeshVertex vertices and 32-bit triangle
+   * indices, along with the bounds of its vertices in model space.
+   */
+  struct MeshBuffers {
+    GLuint vertexBuffer, indexBuffer;
+    GLsizei numIndices;
+    Bounds bounds;
+  };
+
+  /**
+   * Collects the draw calls of a frame so that they can be made in the order
+   * that changes the least GL state, rather than in scene graph order.
+   *
+   * Each queued draw is given a 64-bit sort key made of (from the most
+   * significant bits down) its shader program, its texture and its vertex
+   * buffer, so that sorting the keys groups draws by the state that is the
+   * most expensive to change. When the queue is submitted, the shader (along
+   * with the projection and the vertex attributes), the texture and the mesh
+   * buffers are each only changed when the next draw needs a different one.
+   *
+   * Draws queued with an instanced shader are also batched: each run of at
+   * least RENDER_QUEUE_MIN_INSTANCES draws that share a shader, texture and
+   * mesh is made as one instanced draw call, with the model-view matrices
+   * streamed to the GL as a per-instance vertex attribute. This needs GL 3.3
+   * or ARB_instanced_arrays, or ANGLE_instanced_arrays under WebGL, and
+   * without them each draw is made on its own.
+   */
+  class RenderQueue {
+    public:
+      /**
+       * What the last submit() did, for checking that sorting pays off.
+       */
+      struct Stats {
+        uint32_t drawCalls;  // including the instanced ones
+        uint32_t instancedDrawCalls, instances;
+        uint32_t shaderChanges, textureChanges, meshChanges;
+      };
+
+      RenderQueue();
+      ~RenderQueue();
+
+      /**
+       * Queues a draw of 'mesh' with 'shader' and 'texture' (0 for none).
+       * The mesh and shaders must stay alive until the queue is submitted.
+       *
+       * \param instancedShader Optionally, a shader that draws the same way
+       * as 'shader' but takes the model-view matrix from the
+       * instanceModelView attribute, to be used when this draw is batched
+       * with others.
+       */
+      void push(const ShaderProgram *shader, GLuint texture,
+          const MeshBuffers *mesh, const glm::mat4 &modelView,
+          const ShaderProgram *instancedShader = nullptr);
+
+      /**
+       * Makes every queued draw, sorted by key, and empties the queue.
+       * Draws with the same key are made in the order they were queued.
+       */
+      void submit(const glm::mat4 &projection);
+
+      const Stats &stats() const { return m_stats; }
+
+      /**
+       * Turns the batching of draws into instanced draw calls on or off (it
+       * only happens where the GL supports it). It is off by default until
+       * it has been measured against separate draws on real GL and WebGL.
+       */
+      void setInstancing(bool instancing) { m_instancing = instancing; }
+      /**
+       * \return Whether the GL supports instanced draw calls.
+       */
+      static bool instancingSupported();
+
+    private:
+      struct DrawItem {
+        const ShaderProgram *shader;
+        const MeshBuffers *mesh;
+        GLuint texture;
+        glm::mat4 modelView;
+        const ShaderProgram *instancedShader;
+      };
+      std::vector<DrawItem> m_items;
+      // Only the keys and item indices are sorted, not the items themselves
+      std::vector<std::pair<uint64_t, uint32_t>> m_order;
+      Stats m_stats;
+      bool m_instancing;
+      GLuint m_instanceBuffer;
+      std::vector<glm::mat4> m_instanceModelViews;
+      // The GL state set so far by the submission under way
+      const ShaderProgram *m_shader;
+      const MeshBuffers *m_mesh;
+      GLuint m_texture;
+      bool m_textureBound;
+
+      void m_draw(const DrawItem &item, const glm::mat4 &projection);
+      void m_drawInstanced(size_t first, size_t count,
+          const glm::mat4 &projection);
+      void m_setState(const ShaderProgram *shader, GLuint texture,
+          const MeshBuffers *mesh, const glm::mat4 &projection);
+  };
+}
+
+#endif
@@ -21,14 +21,21 @@
  * IN THE SOFTWARE.
  */
 
+#include <glm/gtc/matrix_transform.hpp>
+
 #include "camera.h"
+#include "frustum.h"
 #include "sceneObject.h"
-#include "transformStack.h"
 
 #include "scene.h"
 
+/*
+ * The parent of the nodes of top-level scene objects
+ */
+#define SCENE_NO_PARENT UINT32_MAX
+
 namespace ld2016 {
-  Scene::Scene() {
+  Scene::Scene() : m_nodesVersion(0), m_cullStats() {
     // TODO
   }
 
@@ -38,6 +45,7 @@ namespace ld2016 {
 
   void Scene::addObject(std::shared_ptr<SceneObject> object) {
     this->m_objects.insert({object.get(), object});
+    ++SceneObject::m_graphVersion();
   }
 
   void Scene::removeObject(const SceneObject *address) {
@@ -46,6 +54,7 @@ namespace ld2016 {
     // FIXME: Remove this node from its parent
 //    iterator->parent()->removeChild(address);
     m_objects.erase(address);
+    ++SceneObject::m_graphVersion();
   }
 
   bool Scene::handleEvent(const SDL_Event &event) {
@@ -59,23 +68,162 @@ namespace ld2016 {
   void Scene::draw(const Camera &camera, float aspect,
       float alpha, bool debug) const
   {
-    // Start with an empty modelWorld transform stack
-    TransformStack modelWorld;
+    // Find where everything is, and the bounds of each subtree, before
+    // anything is drawn
+    m_update(alpha);
 
     // Obtain transforms from the camera
     auto worldView = camera.worldView(alpha);
     auto projection = camera.projection(aspect, alpha);
+    Frustum frustum(projection * worldView);
 
     // TODO: Draw the skybox first
 
-    // Iterate through all top-level scene objects and draw them
-    for (auto object : this->m_objects) {
-      object.second->m_draw(
-          modelWorld,
-          worldView,
-          projection,
-          alpha,
-          debug);
+    // Walk the nodes in order, drawing those in view, and stepping over the
+    // whole subtree of any node whose subtree is out of view
+    m_cullStats = CullStats();
+    uint32_t i = 0;
+    while (i < m_nodes.size()) {
+      const Node &node = m_nodes[i];
+      if (node.subtreeExtent == EXTENT_BOUNDED
+          && !frustum.intersects(node.subtreeBounds)) {
+        m_cullStats.culled += node.end - i;
+        i = node.end;
+        continue;
+      }
+      if (node.extent == EXTENT_BOUNDED && node.end != i + 1
+          && !frustum.intersects(node.bounds)) {
+        ++m_cullStats.culled;
+      } else {
+        // Delegate the actual drawing to derived classes
+        node.object->draw(node.world, worldView, projection, alpha, debug);
+        node.object->enqueue(m_renderQueue, node.world, worldView, alpha);
+        ++m_cullStats.visible;
+      }
+      ++i;
+    }
+    m_renderQueue.submit(projection);
+  }
+
+  void Scene::m_flatten() const {
+    m_nodes.clear();
+    for (auto &object : m_objects) {
+      m_flatten(object.second.get(), SCENE_NO_PARENT);
+    }
+    m_nodesVersion = SceneObject::m_graphVersion();
+  }
+
+  void Scene::m_flatten(SceneObject *object, uint32_t parent) const {
+    uint32_t index = (uint32_t) m_nodes.size();
+    Node node;
+    node.object = object;
+    node.parent = parent;
+    // Everything is found again the first time through
+    node.localTick = 0;
+    node.localAlpha = 0.f;
+    node.localStill = false;
+    node.boundsTick = 0;
+    m_nodes.push_back(node);
+    for (auto &child : object->m_children) {
+      m_flatten(child.second.get(), index);
+    }
+    m_nodes[index].end = (uint32_t) m_nodes.size();
+  }
+
+  void Scene::m_update(float alpha) const {
+    if (m_nodesVersion != SceneObject::m_graphVersion()) {
+      m_flatten();
+    }
+
+    // Parents come before their children, so each parent's world transform
+    // is found before those of its children
+    glm::mat4 identity;
+    for (Node &node : m_nodes) {
+      bool parentMoved =
+        node.parent != SCENE_NO_PARENT && m_nodes[node.parent].moved;
+      node.moved = m_updateLocal(node, alpha) || parentMoved;
+      if (node.moved) {
+        const glm::mat4 &parentWorld = node.parent == SCENE_NO_PARENT
+          ? identity : m_nodes[node.parent].world;
+        node.world = node.localComps ? parentWorld * node.local : parentWorld;
+      }
+      ecs::State *state = node.object->state;
+      node.boundsChanged = node.moved || node.boundsTick == 0
+        || state->changedSince<ecs::Scale>(
+            node.object->id, node.boundsTick);
+      if (node.boundsChanged) {
+        node.extent = node.object->bounds(&node.bounds);
+        if (node.extent == EXTENT_BOUNDED) {
+          node.bounds = node.bounds.transformed(node.world);
+        }
+        node.boundsTick = state->currentTick();
+      }
+    }
+
+    // Going backwards, the bounds of every subtree below a node are found
+    // before its own, and only subtrees with changes in them are merged again
+    for (uint32_t i = (uint32_t) m_nodes.size(); i-- > 0; ) {
+      Node &node = m_nodes[i];
+      if (!node.boundsChanged) {
+        continue;
+      }
+      node.subtreeExtent = node.extent;
+      node.subtreeBounds = node.bounds;
+      for (uint32_t child = i + 1; child < node.end;
+          child = m_nodes[child].end)
+      {
+        const Node &childNode = m_nodes[child];
+        if (node.subtreeExtent == EXTENT_UNBOUNDED
+            || childNode.subtreeExtent == EXTENT_NOTHING) {
+          continue;
+        }
+        if (childNode.subtreeExtent == EXTENT_UNBOUNDED
+            || node.subtreeExtent == EXTENT_NOTHING) {
+          node.subtreeExtent = childNode.subtreeExtent;
+          node.subtreeBounds = childNode.subtreeBounds;
+        } else {
+          node.subtreeBounds.merge(childNode.subtreeBounds);
+        }
+      }
+      if (node.parent != SCENE_NO_PARENT) {
+        m_nodes[node.parent].boundsChanged = true;
+      }
+    }
+  }
+
+  bool Scene::m_updateLocal(Node &node, float alpha) const {
+    ecs::State *state = node.object->state;
+    const ecs::entityId &id = node.object->id;
+    ecs::Existence* existence;
+    ecs::CompOpReturn status = state->getExistence(id, &existence);
+    assert(status == ecs::SUCCESS);
+
+    ecs::compMask comps = existence->componentsPresent
+      & (ecs::ENUM_Position | ecs::ENUM_Orientation);
+    if (node.localTick != 0 && comps == node.localComps
+        && !state->changedSince<ecs::Position>(id, node.localTick)
+        && !state->changedSince<ecs::Orientation>(id, node.localTick)
+        && (alpha == node.localAlpha || node.localStill)) {
+      return false;
+    }
+    node.local = glm::mat4();
+    node.localStill = true;
+    if (comps.intersects(ecs::ENUM_Position)) {
+      ecs::Position *position = state->get<ecs::Position>(id);
+      // Translate the object into position
+      node.local *= glm::translate(glm::mat4(), position->getVec(alpha));
+      node.localStill = position->lastVec == position->vec;
+    }
+    if (comps.intersects(ecs::ENUM_Orientation)) {
+      ecs::Orientation *orientation = state->get<ecs::Orientation>(id);
+      // Apply the object orientation as a rotation
+      node.local *= glm::mat4_cast(orientation->getQuat(alpha));
+      node.localStill = node.localStill
+        && orientation->lastQuat == orientation->quat;
     }
+    node.localTick = state->currentTick();
+    node.localAlpha = alpha;
+    node.localComps = comps;
+    return true;
   }
 }
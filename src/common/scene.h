@@ -29,20 +29,61 @@
 #include <unordered_map>
 #include <vector>
 
+#include "renderQueue.h"
+#include "sceneObject.h"
+
 namespace ld2016 {
   class Camera;
-  class SceneObject;
   /**
    * This class implements a simple graphics scene.
    *
    * OpenGL is typically used under the hood, but nothing about this scene
    * class requires the use of any specific graphics library.
+   *
+   * The scene graph is drawn from a flattened copy of it, in which each
+   * scene object is a node that comes after its parent and right before the
+   * nodes of its own subtree. Each node keeps the object's local and world
+   * transforms and bounds from one frame to the next, and only those of the
+   * objects that moved (and everything below them) are found again. The
+   * graph is only flattened again when its shape changes.
    */
   class Scene {
     private:
+      struct Node {
+        SceneObject *object;
+        uint32_t parent;  // SCENE_NO_PARENT at the top level
+        uint32_t end;  // one past the last node of this one's subtree
+        // The object's own translation and rotation, only rebuilt when its
+        // Position or Orientation has changed since localTick (see
+        // ecs::BasicState::changedSince), or when it is drawn with a
+        // different alpha while its keyframes differ
+        glm::mat4 local;
+        uint32_t localTick;
+        float localAlpha;
+        ecs::compMask localComps;
+        bool localStill;
+        glm::mat4 world;
+        bool moved;  // whether the world transform changed this frame
+        // The bounds of the object and of the subtree below it are only
+        // meaningful when bounded, and the subtree is only bounded when
+        // everything in it is bounded or draws nothing
+        uint32_t boundsTick;
+        Extent extent, subtreeExtent;
+        Bounds bounds, subtreeBounds;
+        bool boundsChanged;
+      };
       std::unordered_map<
         const SceneObject *,
         std::shared_ptr<SceneObject>> m_objects;
+      mutable std::vector<Node> m_nodes;
+      mutable uint32_t m_nodesVersion;
+      mutable RenderQueue m_renderQueue;
+      mutable CullStats m_cullStats;
+
+      void m_flatten() const;
+      void m_flatten(SceneObject *object, uint32_t parent) const;
+      void m_update(float alpha) const;
+      bool m_updateLocal(Node &node, float alpha) const;
 
     public:
       /**
@@ -81,7 +122,11 @@ namespace ld2016 {
       bool handleEvent(const SDL_Event &event);
 
       /**
-       * Draws the scene by recursively drawing all of its scene objects.
+       * Draws the scene by drawing all of its scene objects in one pass over
+       * the flattened scene graph, and then submitting the draw calls they
+       * queued (see SceneObject::enqueue()). Scene objects outside of the camera's view
+       * are skipped, along with their children when those are out of view
+       * as well (see SceneObject::bounds()).
        *
        * \param camera The camera that dictates the world-view and projection
        * transforms to use when drawing the scene.
@@ -100,6 +145,30 @@ namespace ld2016 {
        */
       void draw(const Camera &camera, float aspect,
           float alpha = 1.0, bool debug = false) const;
+
+      /**
+       * \return The draw calls and GL state changes made by the last call to
+       * draw() for the queued draw calls.
+       */
+      const RenderQueue::Stats &renderStats() const {
+        return m_renderQueue.stats();
+      }
+
+      /**
+       * \return How many scene objects the last call to draw() drew, and how
+       * many it skipped for being out of view.
+       */
+      const CullStats &cullStats() const {
+        return m_cullStats;
+      }
+
+      /**
+       * Turns the batching of alike draws into instanced draw calls on or
+       * off (see RenderQueue::setInstancing).
+       */
+      void setInstancing(bool instancing) {
+        m_renderQueue.setInstancing(instancing);
+      }
   };
 }
 
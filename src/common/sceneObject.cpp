@@ -24,8 +24,6 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "transformRAII.h"
-
 #include "sceneObject.h"
 
 namespace ld2016 {
@@ -42,6 +40,7 @@ namespace ld2016 {
   void SceneObject::addChild(std::shared_ptr<SceneObject> child) {
     m_children.insert({child.get(), child});
     child.get()->m_parent = this;
+    ++m_graphVersion();
   }
   void SceneObject::removeChild(const SceneObject *address) {
     auto iterator = m_children.find(address);
@@ -49,40 +48,15 @@ namespace ld2016 {
     // TODO: Set the m_parent member of this child to nullptr (SceneObjects
     // do not have m_parent members at the time of this writing).
     m_children.erase(iterator);
+    ++m_graphVersion();
   }
   bool SceneObject::hasChild(const SceneObject *address) {
     return m_children.find(address) != m_children.end();
   }
 
-  void SceneObject::m_draw(Transform &modelWorld, const glm::mat4 &worldView,
-      const glm::mat4 &projection, float alpha, bool debug)
-  {
-    TransformRAII mw(modelWorld);
-
-    ecs::Existence* existence;
-    ecs::CompOpReturn status = state->getExistence(id, &existence);
-    assert(status == ecs::SUCCESS);
-
-    if (existence->flagIsOn(ecs::ENUM_Position)) {
-      ecs::Position *position;
-      state->getPosition(id, &position);
-      // Translate the object into position
-      mw *= glm::translate(glm::mat4(), position->getVec(alpha));
-    }
-    if (existence->flagIsOn(ecs::ENUM_Orientation)) {
-      ecs::Orientation *orientation;
-      state->getOrientation(id, &orientation);
-      // Apply the object orientation as a rotation
-      mw *= glm::mat4_cast(orientation->getQuat(alpha));
-    }
-
-    // Delegate the actual drawing to derived classes
-    this->draw(mw.peek(), worldView, projection, alpha, debug);
-
-    // Draw our children
-    for (auto child : m_children) {
-      child.second->m_draw(mw, worldView, projection, alpha, debug);
-    }
+  uint32_t &SceneObject::m_graphVersion() {
+    static uint32_t version = 0;
+    return version;
   }
 
   void SceneObject::reverseTransformLookup(glm::mat4 &wv, float alpha) const {
@@ -111,6 +85,11 @@ namespace ld2016 {
   void
   SceneObject::draw(const glm::mat4 &modelWorld, const glm::mat4 &worldView, const glm::mat4 &projection, float alpha,
                     bool debug) { }
+  void SceneObject::enqueue(RenderQueue &queue, const glm::mat4 &modelWorld,
+                            const glm::mat4 &worldView, float alpha) { }
+  Extent SceneObject::bounds(Bounds *bounds) const {
+    return EXTENT_UNBOUNDED;
+  }
   ecs::entityId SceneObject::getId() const {
     return id;
   }
@@ -31,9 +31,18 @@
 #include <memory>
 #include <unordered_map>
 #include "ecs/ecsState.h"
+#include "frustum.h"
 
 namespace ld2016 {
-  class Transform;
+  class RenderQueue;
+
+  /**
+   * What a scene object can tell of where it draws (see
+   * SceneObject::bounds()).
+   */
+  enum Extent {
+    EXTENT_NOTHING, EXTENT_BOUNDED, EXTENT_UNBOUNDED
+  };
   /**
    * This abstract class defines a typical object in a 3D graphics scene.
    *
@@ -52,10 +61,10 @@ namespace ld2016 {
       SceneObject* m_parent = NULL;
 
       /**
-       * This method recursively draws this object and all of its children.
+       * Counts the changes made to the shape of every scene graph, so that
+       * each scene knows when to flatten its graph again (see Scene).
        */
-      void m_draw(Transform &modelWorld, const glm::mat4 &worldView,
-                  const glm::mat4 &projection, float alpha, bool debug);
+      static uint32_t &m_graphVersion();
 
     protected:
       ecs::State* state;
@@ -127,13 +136,50 @@ namespace ld2016 {
        * \param debug Flag indicating whether or not debug information is to be
        * drawn.
        *
-       * Derived classes must implement this method in order for their scene
-       * objects to be visible.
+       * Derived classes must implement this method or enqueue() in order for
+       * their scene objects to be visible.
        */
       virtual void draw(const glm::mat4 &modelWorld,
                         const glm::mat4 &worldView, const glm::mat4 &projection,
                         float alpha, bool debug);
 
+      /**
+       * Queues the draw calls of this scene object, which are made after the
+       * whole scene has been walked, sorted so as to change as little GL state
+       * as possible (see RenderQueue). Scene objects drawn with a mesh, a
+       * texture and a shader should do this instead of drawing themselves in
+       * draw(). The default behavior of this method is to queue nothing.
+       *
+       * \param queue The queue of the scene being drawn.
+       * \param modelWorld The model-space to world-space transform for this
+       * scene object's position and orientation.
+       * \param worldView The world-space to view-space transform for the
+       * camera currently being used.
+       * \param alpha The simulation keyframe weight for animating this object
+       * between keyframes.
+       */
+      virtual void enqueue(RenderQueue &queue, const glm::mat4 &modelWorld,
+                           const glm::mat4 &worldView, float alpha);
+
+      /**
+       * Gives the bounds of what this scene object draws, in model space, so
+       * that it is skipped when it is wholly outside of the camera's view.
+       * Whole subtrees of the scene are skipped at once when everything in
+       * them is either bounded or draws nothing. The bounds are only asked
+       * for again when this object or one of its parents moves, or when its
+       * Scale changes. The default behavior of this method is to claim that
+       * this object draws where it can't tell, so that it is never skipped.
+       *
+       * \param bounds Where to write the bounds, when there are any.
+       * \return EXTENT_BOUNDED if the bounds were written, EXTENT_NOTHING if
+       * this object draws nothing, or EXTENT_UNBOUNDED if it draws but can't
+       * tell where, in which case it is never skipped.
+       *
+       * Derived classes should implement this method so that they (and the
+       * subtrees they are in) can be skipped.
+       */
+      virtual Extent bounds(Bounds *bounds) const;
+
       void reverseTransformLookup(glm::mat4& wv, float alpha) const;
 
       /**
@@ -142,6 +188,18 @@ namespace ld2016 {
        */
       ecs::entityId getId() const;
   };
+
+  /**
+   * A scene object that draws nothing, and only serves to move and orient
+   * its children together (a camera gimbal, say).
+   */
+  class Gimbal : public SceneObject {
+    public:
+      Gimbal(ecs::State& state) : SceneObject(state) { }
+
+      // Gimbals draw nothing, so they never keep their subtree from being skipped
+      virtual Extent bounds(Bounds *bounds) const { return EXTENT_NOTHING; }
+  };
 }
 
 #endif
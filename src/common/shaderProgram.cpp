@@ -211,6 +211,8 @@ namespace ld2016 {
         m_shaderProgram, "vertVelocity");
     m_vertStartTimeLocation = glGetAttribLocation(
         m_shaderProgram, "vertStartTime");
+    m_instanceModelViewLocation = glGetAttribLocation(
+        m_shaderProgram, "instanceModelView");
 
     m_texture0 = glGetUniformLocation(
         m_shaderProgram, "texture0");
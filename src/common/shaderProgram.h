@@ -44,6 +44,7 @@ namespace ld2016 {
       GLint m_vertPositionLocation, m_vertNormalLocation, m_vertColorLocation,
              m_vertTexCoordLocation, m_vertVelocityLocation;
       GLint m_vertStartTimeLocation;
+      GLint m_instanceModelViewLocation;
       GLint m_texture0;
 
       static GLuint m_compileShader(
@@ -170,10 +171,20 @@ namespace ld2016 {
        * attribute from ShaderProgram.
        */
       GLint vertStartTimeLocation() const { return m_vertStartTimeLocation; }
+      /**
+       * \return Location of the per-instance model-view matrix attribute in
+       * the shader. Being a matrix, it takes up this location and the three
+       * after it, one for each column.
+       */
+      GLint instanceModelViewLocation() const { return m_instanceModelViewLocation; }
       /**
        * \return Location of the first texture sampler uniform in the shader.
        */
       GLint texture0() const { return m_texture0; }
+      /**
+       * \return The GL name of the linked shader program.
+       */
+      GLuint program() const { return m_shaderProgram; }
 
       /**
        * Use this shader in the current GL state.
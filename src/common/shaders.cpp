@@ -63,6 +63,10 @@ DEFINE_SHADER(wireframe)
 #include "assets_shaders_texture.frag.c"
 DEFINE_SHADER(texture)
 
+#include "assets_shaders_textureInstanced.vert.c"
+#include "assets_shaders_textureInstanced.frag.c"
+DEFINE_SHADER(textureInstanced)
+
 #include "assets_shaders_skyQuad.vert.c"
 #include "assets_shaders_skyQuad.frag.c"
 DEFINE_SHADER(skyQuad)
@@ -58,6 +58,9 @@ namespace ld2016 {
       /** Shader for drawing textures */
       DECLARE_SHADER(texture);
 
+      /** Shader for drawing many instances of a textured mesh at once */
+      DECLARE_SHADER(textureInstanced);
+
       /** Shader for drawing skybox */
       DECLARE_SHADER(skyQuad);
   };
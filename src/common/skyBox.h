@@ -39,6 +39,8 @@ namespace ld2016 {
       virtual void draw(const glm::mat4 &modelWorld,
                         const glm::mat4 &worldView, const glm::mat4 &projection,
                         float alpha, bool debug);
+      // The sky surrounds the camera wherever it is
+      virtual Extent bounds(Bounds *bounds) const { return EXTENT_UNBOUNDED; }
   };
 }
 
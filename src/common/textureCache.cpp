@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include "stb_image.h"
+
+#include "glError.h"
+
+#include "textureCache.h"
+
+namespace ld2016 {
+  std::shared_ptr<const Texture> TextureCache::get(
+      const std::string &textureFile)
+  {
+    std::weak_ptr<const Texture> &entry = m_textures()[textureFile];
+    std::shared_ptr<const Texture> texture = entry.lock();
+    if (texture) {
+      return texture;
+    }
+    Texture *loaded = new Texture();
+    if (!m_load(textureFile, loaded)) {
+      delete loaded;
+      m_textures().erase(textureFile);
+      return nullptr;
+    }
+    // Whoever lets go of the texture last deletes it and its entry
+    texture = std::shared_ptr<const Texture>(loaded,
+        [textureFile](const Texture *loaded) {
+          glDeleteTextures(1, &loaded->texture);
+          delete loaded;
+          auto found = m_textures().find(textureFile);
+          if (found != m_textures().end() && found->second.expired()) {
+            m_textures().erase(found);
+          }
+        });
+    entry = texture;
+    return texture;
+  }
+
+  size_t TextureCache::size() {
+    return m_textures().size();
+  }
+
+  std::unordered_map<std::string, std::weak_ptr<const Texture>> &
+  TextureCache::m_textures() {
+    static std::unordered_map<std::string,
+      std::weak_ptr<const Texture>> textures;
+    return textures;
+  }
+
+  bool TextureCache::m_load(const std::string &textureFile, Texture *texture) {
+    int n;
+    stbi_set_flip_vertically_on_load(true);
+    uint8_t* data = stbi_load(textureFile.c_str(), &texture->width, &texture->height, &n, 0);
+    if (!data) {
+      fprintf(stderr, "Failed to load texture file '%s'.\n", textureFile.c_str());
+      return false;
+    }
+    // Create the texture object in the GL
+    glGenTextures(1, &texture->texture);
+    FORCE_ASSERT_GL_ERROR();
+    glBindTexture(GL_TEXTURE_2D, texture->texture);
+    FORCE_ASSERT_GL_ERROR();
+    // Copy the image to the GL
+    glTexImage2D(
+        GL_TEXTURE_2D,  // target
+        0,  // level
+        GL_RGBA,  // internal format
+        texture->width,  // width
+        texture->height,  // height
+        0,  // border
+        GL_RGBA,  // format
+        GL_UNSIGNED_BYTE,  // type
+        data  // data
+        );
+    FORCE_ASSERT_GL_ERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    FORCE_ASSERT_GL_ERROR();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    FORCE_ASSERT_GL_ERROR();
+    stbi_image_free(data);
+    return true;
+  }
+}
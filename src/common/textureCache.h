@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LD2016_COMMON_TEXTURE_CACHE_H_
+#define LD2016_COMMON_TEXTURE_CACHE_H_
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace ld2016 {
+  /**
+   * A 2D texture in the GL.
+   */
+  struct Texture {
+    GLuint texture;
+    int width, height;
+  };
+
+  /**
+   * Loads each image file once and shares its GL texture among everything
+   * that draws with it, in the same way as MeshCache does for meshes: the
+   * texture is deleted as soon as its last user lets go of it, and textures
+   * may only be asked for and released on the thread that owns the GL
+   * context.
+   */
+  class TextureCache {
+    public:
+      /**
+       * \param textureFile Path to a PNG image.
+       * \return The texture loaded from the given file, shared with every
+       * other user of the same path, or null if the file couldn't be loaded.
+       */
+      static std::shared_ptr<const Texture> get(const std::string &textureFile);
+
+      /**
+       * \return The number of textures currently loaded.
+       */
+      static size_t size();
+
+    private:
+      static std::unordered_map<std::string,
+        std::weak_ptr<const Texture>> &m_textures();
+      static bool m_load(const std::string &textureFile, Texture *texture);
+  };
+}
+
+#endif
@@ -1,52 +0,0 @@
-/*
- * Copyright (c) 2016 Jonathan Glines
- * Jonathan Glines <jonathan@glines.net>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to
- * deal in the Software without restriction, including without limitation the
- * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
- * sell copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
- * IN THE SOFTWARE.
- */
-
-#include "transformStack.h"
-
-namespace ld2016 {
-  TransformStack::TransformStack() {
-    m_stack.push(glm::mat4());
-  }
-
-  TransformStack::~TransformStack() {
-  }
-
-  const Transform &TransformStack::operator*=(const glm::mat4 &matrix) {
-    this->push(matrix);
-    return *this;
-  }
-
-  void TransformStack::push(glm::mat4 matrix) {
-    this->m_stack.push(
-        this->m_stack.top() * matrix);
-  }
-
-  void TransformStack::pop() {
-    this->m_stack.pop();
-  }
-
-  void TransformStack::unwind(size_t size) {
-    while (m_stack.size() > size)
-      m_stack.pop();
-  }
-}
@@ -23,6 +23,7 @@
  */
 
 //#include <cstdlib>
+#include <cstring>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -39,6 +40,10 @@
 #include "./common/ecs/ecsSystem_movement.h"
 #include "./common/ecs/ecsSystem_controls.h"
 #include "./common/ecs/ecsSystem_physics.h"
+#include "./common/ecs/ecsScheduler.h"
+
+#define WORKER_THREADS jobs::WorkerPool::defaultNumWorkers() // threads to run systems and their per-entity loops on
+#define ENTITY_GRAIN 256 // entities handed to a thread at a time by a system's parallelFor
 
 using namespace ld2016;
 using namespace ecs;
@@ -56,11 +61,27 @@ class PyramidGame : public Game {
     ControlSystem controlSystem;
     MovementSystem movementSystem;
     PhysicsSystem physicsSystem;
+    jobs::WorkerPool workerPool;
+    Scheduler scheduler;
+    bool reportSystemStats = false; // print the scheduler's per-system timings every frame (--report-systems)
   public:
     Delegate<bool(SDL_Event&)> systemsHandlerDlgt;
+    Delegate<void(float)> tickDlgt;
     PyramidGame(int argc, char **argv)
-        : Game(argc, argv, "Pyramid Game"), controlSystem(&state), movementSystem(&state), physicsSystem(&state) {
+        : Game(argc, argv, "Pyramid Game"), controlSystem(&state), movementSystem(&state), physicsSystem(&state),
+          workerPool(WORKER_THREADS), scheduler(&workerPool) {
       systemsHandlerDlgt = DELEGATE(&PyramidGame::systemsHandler, this);
+      tickDlgt = DELEGATE(&PyramidGame::tick, this);
+      for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--report-systems") == 0) {
+          reportSystemStats = true;
+        }
+      }
+      movementSystem.setWorkerPool(&workerPool, ENTITY_GRAIN);
+      physicsSystem.setWorkerPool(&workerPool, ENTITY_GRAIN);
+      scheduler.addSystem(controlSystem, "control");
+      scheduler.addSystem(movementSystem, "movement");
+      scheduler.addSystem(physicsSystem, "physics");
     }
     EcsResult init() {
       assert(controlSystem.init());
@@ -94,7 +115,7 @@ class PyramidGame : public Game {
               glm::angleAxis((float) M_PI, glm::vec3(1.0f, 0.0f, 0.0f)),
               {0.105f, 0.105f, 0.25f}));
       m_camGimbal = std::shared_ptr<SceneObject> (
-          new SceneObject(state));
+          new Gimbal(state));
       m_skyBox = std::shared_ptr<SkyBox> (
           new SkyBox(state));
       float delta = 0.3f;
@@ -125,7 +146,7 @@ class PyramidGame : public Game {
       this->setCamera(m_camera);
 
       entityId gimbalId = m_camGimbal->getId();
-      state.addPosition(gimbalId, {0.f, 0.f, 1.f});
+      state.addPosition(gimbalId, glm::vec3(0.f, 0.f, 1.f));
       state.addOrientation(gimbalId, glm::quat());
       state.addMouseControls(gimbalId, false, false);
 
@@ -133,23 +154,18 @@ class PyramidGame : public Game {
       state.addWasdControls(bottomId, gimbalId, WasdControls::ROTATE_ABOUT_Z);
       float sphereRadius = 0.8f;
       state.addPhysics(bottomId, 1.f, &sphereRadius, Physics::SPHERE);
-      /*std::vector<float> hullVerts = {
-          *//*{ 0.f,  0.f, -0.2f},
-          {-.2f, -.2f, 0.f},
-          {-.2f,  .2f, 0.f},
-          { .2f, -.2f, 0.f},
-          { .2f,  .2f, 0.f}*//*
-           1.f,  0.f,  0.f,
-           0.f,  1.f,  0.f,
-           0.f,  0.f,  1.f,
-          -1.f,  0.f,  0.f,
-           0.f, -1.f,  0.f,
-           0.f,  0.f, -1.f
-      };
-      state.addPhysics(bottomId, 1.f, &hullVerts, Physics::MESH);*/
+      // To collide with the pyramid's actual shape instead, use the hull baked from its mesh at build time:
+      // state.addPhysics(bottomId, 1.f, (void*) "assets/models/pyramid_bottom.hull", Physics::HULL_FILE);
 
       Physics* physics;
       state.getPhysics(bottomId, &physics);
+      if (!physics->rigidBody) {
+        // The shape couldn't be made (a missing or corrupt hull file, say), so fall back to a sphere
+        fprintf(stderr, "Falling back to a sphere for the pyramid's physics\n");
+        state.remPhysics(bottomId);
+        state.addPhysics(bottomId, 1.f, &sphereRadius, Physics::SPHERE);
+        state.getPhysics(bottomId, &physics);
+      }
       physics->rigidBody->setActivationState(DISABLE_DEACTIVATION);
 
       entityId topId = m_pyrTop->getId();
@@ -224,21 +240,27 @@ class PyramidGame : public Game {
       return controlSystem.handleEvent(event);
     }
     void tick(float dt) {
-      controlSystem.tick(dt);
-      movementSystem.tick(dt);
-      physicsSystem.tick(dt);
+      controlSystem.takeInputSnapshot();
+      scheduler.tick(dt);
+    }
+    /*
+     * Prints the wall time, parallelism and time per system of the last tick, when asked to on the command line
+     */
+    void reportFrame() {
+      if (reportSystemStats) {
+        fprintf(stderr, "%s\n", scheduler.getFrameReport().c_str());
+      }
     }
 };
 
 void main_loop(void *instance) {
   PyramidGame *game = (PyramidGame *) instance;
-  float dt;
-  bool keepGoing = game->mainLoop(game->systemsHandlerDlgt, dt);
+  bool keepGoing = game->mainLoop(game->systemsHandlerDlgt, game->tickDlgt);
+  game->reportFrame();
   if (!keepGoing) {
     game->deInit();
     exit(0);
   }
-  game->tick(dt);
 }
 
 int main(int argc, char **argv) {
@@ -54,9 +54,11 @@ class AnimationDemo : public Game {
     MovementSystem movementSystem;
   public:
     Delegate<bool(SDL_Event&)> systemsHandlerDlgt;
+    Delegate<void(float)> tickDlgt;
     AnimationDemo(int argc, char **argv)
         : Game(argc, argv, "Animation Demo"), wasdSystem(&state), movementSystem(&state) {
       systemsHandlerDlgt = DELEGATE(&AnimationDemo::systemsHandler, this);
+      tickDlgt = DELEGATE(&AnimationDemo::tick, this);
     }
     EcsResult init() {
       assert(wasdSystem.init());
@@ -85,7 +87,7 @@ class AnimationDemo : public Game {
                          glm::angleAxis((float) M_PI, glm::vec3(1.0f, 0.0f, 0.0f)),
                          {0.105f, 0.105f, 0.25f}));
       m_camGimbal = std::shared_ptr<SceneObject>(
-          new SceneObject(state));
+          new Gimbal(state));
       float delta = 0.3f;
       for (int i = 0; i < 100; ++i) {
         Debug::drawLine( state,
@@ -123,7 +125,7 @@ class AnimationDemo : public Game {
       m_camGimbal->addChild(m_camera);
 
       entityId gimbalId = m_camGimbal->getId();
-      state.addPosition(gimbalId, {0.f, 0.f, 1.f});
+      state.addPosition(gimbalId, glm::vec3(0.f, 0.f, 1.f));
       state.addOrientation(gimbalId, glm::quat());
       state.addMouseControls(gimbalId, false, false);
 
@@ -201,6 +203,7 @@ class AnimationDemo : public Game {
       return wasdSystem.handleEvent(event);
     }
     void tick(float dt) {
+      wasdSystem.takeInputSnapshot();
       wasdSystem.tick(dt);
       movementSystem.tick(dt);
     }
@@ -208,9 +211,7 @@ class AnimationDemo : public Game {
 
 void main_loop(void *instance) {
   AnimationDemo *demo = (AnimationDemo *) instance;
-  float dt;
-  demo->mainLoop(demo->systemsHandlerDlgt, dt);
-  demo->tick(dt);
+  demo->mainLoop(demo->systemsHandlerDlgt, demo->tickDlgt);
 }
 
 int main(int argc, char **argv) {
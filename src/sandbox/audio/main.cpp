@@ -46,10 +46,12 @@ class AudioDemo : public Game {
   private:
   public:
     Delegate<bool(SDL_Event&)> systemsHandlerDlgt;
+    Delegate<void(float)> tickDlgt;
     AudioDemo(int argc, char **argv)
         : Game(argc, argv, "Pyramid Game")
     {
       systemsHandlerDlgt = DELEGATE(&AudioDemo::systemsHandler, this);
+      tickDlgt = DELEGATE(&AudioDemo::tick, this);
     }
     EcsResult init() {
       return ECS_SUCCESS;
@@ -87,9 +89,7 @@ void audioCallback(
 
 void main_loop(void *instance) {
   AudioDemo *demo = (AudioDemo *) instance;
-  float dt;
-  demo->mainLoop(demo->systemsHandlerDlgt, dt);
-  demo->tick(dt);
+  demo->mainLoop(demo->systemsHandlerDlgt, demo->tickDlgt);
 }
 
 int main(int argc, char **argv) {
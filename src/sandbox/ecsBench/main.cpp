@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Compares the component storage layouts available to the ECS on a typical multi-component query:
+ * every entity with Position, Orientation and WasdControls has its position pushed along by its acceleration.
+ *
+ *   kvmap     - one hash map per component type (the original layout), one lookup per component per entity
+ *   pools     - ecs::State with its sparse-set pools, iterating an id list like a System's registry does
+ *   archetype - ecs::ArchetypeStorage, walking the columns of each matching chunk directly
+ *
+ * With 'scaling' as the first argument, it instead measures how a System-style parallelFor over the pools layout
+ * (see jobsParallelFor.h) scales with entity count and thread count, relative to one thread.
+ *
+ * Usage: ecsBench [iterations]
+ *        ecsBench scaling [iterations] [grain] [maxThreads]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../../common/ecs/ecsKvMap.h"
+#include "../../common/ecs/ecsState.h"
+#include "../../common/ecs/ecsArchetypes.h"
+#include "../../common/jobs/jobsParallelFor.h"
+
+using namespace ecs;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const float dt = 1.f / 60.f;
+static const compMask queryMask = ENUM_Position | ENUM_Orientation | ENUM_WasdControls;
+
+static double millisSince(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/*
+ * Every other entity gets WasdControls, so half of them match the query. The rest are split between two other
+ * archetypes so that the query actually has something to skip over.
+ */
+static inline bool hasControls(uint32_t i) { return (i & 1) == 0; }
+static inline bool hasScale(uint32_t i) { return (i & 3) == 1; }
+
+struct Result {
+  double createMs, iterateMs;
+  float checksum;
+};
+
+static Result benchKvMap(uint32_t numEntities, int iterations) {
+  KvMap<entityId, Existence> existences;
+  KvMap<entityId, Position> positions;
+  KvMap<entityId, Orientation> orientations;
+  KvMap<entityId, Scale> scales;
+  KvMap<entityId, WasdControls> controls;
+  std::vector<entityId> ids;
+  Result result;
+
+  Clock::time_point start = Clock::now();
+  for (entityId id = 1; id <= numEntities; ++id) {
+    Existence existence;
+    existence.turnOnFlags(ENUM_Existence | ENUM_Position | ENUM_Orientation);
+    positions.emplace(id, Position(glm::vec3(0.f, 0.f, 0.f)));
+    orientations.emplace(id, Orientation(glm::quat()));
+    if (hasScale(id - 1)) {
+      scales.emplace(id, Scale(glm::vec3(1.f, 1.f, 1.f)));
+      existence.turnOnFlags(ENUM_Scale);
+    }
+    if (hasControls(id - 1)) {
+      controls.emplace(id, WasdControls(id, WasdControls::ROTATE_ABOUT_Z));
+      controls.at(id).accel = glm::vec3(1.f, 0.f, 0.f);
+      existence.turnOnFlags(ENUM_WasdControls);
+    }
+    existences.emplace(id, existence);
+    ids.push_back(id);
+  }
+  result.createMs = millisSince(start);
+
+  start = Clock::now();
+  for (int iter = 0; iter < iterations; ++iter) {
+    for (auto id : ids) {
+      if ((existences.at(id).componentsPresent & queryMask) == queryMask) {
+        positions.at(id).vec += controls.at(id).accel * dt;
+      }
+    }
+  }
+  result.iterateMs = millisSince(start) / iterations;
+  result.checksum = positions.at(1).vec.x;
+  return result;
+}
+
+static Result benchPools(uint32_t numEntities, int iterations) {
+  State state;
+  std::vector<entityId> registry;
+  Result result;
+
+  Clock::time_point start = Clock::now();
+  for (uint32_t i = 0; i < numEntities; ++i) {
+    entityId id;
+    state.createEntity(&id);
+    state.addPosition(id, glm::vec3(0.f, 0.f, 0.f));
+    state.addOrientation(id, glm::quat());
+    if (hasScale(i)) {
+      state.addScale(id, glm::vec3(1.f, 1.f, 1.f));
+    }
+    if (hasControls(i)) {
+      WasdControls* ctrl = nullptr;
+      state.addWasdControls(id, id, WasdControls::ROTATE_ABOUT_Z);
+      state.getWasdControls(id, &ctrl);
+      ctrl->accel = glm::vec3(1.f, 0.f, 0.f);
+      registry.push_back(id);
+    }
+  }
+  result.createMs = millisSince(start);
+
+  start = Clock::now();
+  for (int iter = 0; iter < iterations; ++iter) {
+    for (auto id : registry) {
+      Position* position = nullptr;
+      WasdControls* ctrl = nullptr;
+      state.getPosition(id, &position);
+      state.getWasdControls(id, &ctrl);
+      position->vec += ctrl->accel * dt;
+    }
+  }
+  result.iterateMs = millisSince(start) / iterations;
+  Position* first = nullptr;
+  state.getPosition(1, &first);
+  result.checksum = first->vec.x;
+  return result;
+}
+
+static Result benchArchetypes(uint32_t numEntities, int iterations) {
+  ArchetypeStorage storage;
+  Result result;
+
+  Clock::time_point start = Clock::now();
+  for (uint32_t i = 0; i < numEntities; ++i) {
+    entityId id;
+    storage.createEntity(&id);
+    storage.add<Position>(id, glm::vec3(0.f, 0.f, 0.f));
+    storage.add<Orientation>(id, glm::quat());
+    if (hasScale(i)) {
+      storage.add<Scale>(id, glm::vec3(1.f, 1.f, 1.f));
+    }
+    if (hasControls(i)) {
+      WasdControls* ctrl = nullptr;
+      storage.add<WasdControls>(id, id, WasdControls::ROTATE_ABOUT_Z);
+      storage.get<WasdControls>(id, &ctrl);
+      ctrl->accel = glm::vec3(1.f, 0.f, 0.f);
+    }
+  }
+  result.createMs = millisSince(start);
+
+  start = Clock::now();
+  for (int iter = 0; iter < iterations; ++iter) {
+    storage.forEachChunk(queryMask, [](ArchetypeChunk& chunk) {
+      Position* positions = chunk.column<Position>();
+      WasdControls* ctrls = chunk.column<WasdControls>();
+      for (uint32_t row = 0; row < chunk.count; ++row) {
+        positions[row].vec += ctrls[row].accel * dt;
+      }
+    });
+  }
+  result.iterateMs = millisSince(start) / iterations;
+  Position* first = nullptr;
+  storage.get<Position>(1, &first);
+  result.checksum = first->vec.x;
+  return result;
+}
+
+static void report(const char* name, uint32_t numEntities, const Result& result) {
+  printf("%-10s %9u %12.2f %12.3f %12.2f %10.3f\n", name, numEntities, result.createMs, result.iterateMs,
+         result.iterateMs * 1000000.0 / (numEntities / 2), result.checksum);
+}
+
+/*
+ * Runs the query over the pools layout with 'numThreads' threads (the calling thread plus numThreads - 1 workers).
+ * The per-entity work is a little heavier than in the layout comparison above, closer to what MovementSystem does.
+ */
+static double benchParallelFor(State& state, std::vector<entityId>& registry, uint32_t numThreads, uint32_t grain,
+                               int iterations) {
+  jobs::WorkerPool pool(numThreads - 1);
+  Clock::time_point start = Clock::now();
+  for (int iter = 0; iter < iterations; ++iter) {
+    jobs::parallelForEach(&pool, registry, grain, [&state](const entityId& id) {
+      Position* position = nullptr;
+      WasdControls* ctrl = nullptr;
+      state.getPosition(id, &position);
+      state.getWasdControls(id, &ctrl);
+      position->vec += ctrl->accel * (dt * (1.f + sinf(position->vec.x) * cosf(position->vec.y)));
+    });
+  }
+  return millisSince(start) / iterations;
+}
+
+static void benchScaling(int iterations, uint32_t grain, uint32_t maxThreads) {
+  const uint32_t counts[] = { 1000, 10000, 100000, 1000000 };
+  printf("grain %u, up to %u threads\n", grain, maxThreads);
+  printf("%9s %8s %12s %10s %12s\n", "entities", "threads", "iterate(ms)", "speedup", "efficiency");
+  for (auto count : counts) {
+    State state;
+    std::vector<entityId> registry;
+    for (uint32_t i = 0; i < count; ++i) {
+      entityId id;
+      state.createEntity(&id);
+      state.addPosition(id, glm::vec3(0.f, 0.f, 0.f));
+      state.addOrientation(id, glm::quat());
+      if (hasControls(i)) {
+        WasdControls* ctrl = nullptr;
+        state.addWasdControls(id, id, WasdControls::ROTATE_ABOUT_Z);
+        state.getWasdControls(id, &ctrl);
+        ctrl->accel = glm::vec3(1.f, 0.f, 0.f);
+        registry.push_back(id);
+      }
+    }
+    double oneThreadMs = 0.0;
+    for (uint32_t threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads) {
+      double ms = benchParallelFor(state, registry, threads, grain, iterations);
+      if (threads == 1) {
+        oneThreadMs = ms;
+      }
+      printf("%9u %8u %12.3f %10.2f %11.0f%%\n", count, threads, ms, oneThreadMs / ms,
+             100.0 * oneThreadMs / ms / threads);
+      if (threads == maxThreads) {
+        break;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  bool scaling = argc > 1 && strcmp(argv[1], "scaling") == 0;
+  if (scaling) {
+    --argc;
+    ++argv;
+  }
+  int iterations = argc > 1 ? atoi(argv[1]) : 20;
+  if (iterations < 1) {
+    iterations = 1;
+  }
+  if (scaling) {
+    int grain = argc > 2 ? atoi(argv[2]) : JOBS_DEFAULT_GRAIN;
+    int maxThreads = argc > 3 ? atoi(argv[3]) : (int) jobs::WorkerPool::defaultNumWorkers() + 1;
+    benchScaling(iterations, grain > 0 ? (uint32_t) grain : JOBS_DEFAULT_GRAIN, maxThreads > 0 ? maxThreads : 1);
+    return 0;
+  }
+  const uint32_t counts[] = { 10000, 100000, 1000000 };
+  printf("%-10s %9s %12s %12s %12s %10s\n", "layout", "entities", "create(ms)", "iterate(ms)", "ns/match", "checksum");
+  for (auto count : counts) {
+    report("kvmap", count, benchKvMap(count, iterations));
+    report("pools", count, benchPools(count, iterations));
+    report("archetype", count, benchArchetypes(count, iterations));
+  }
+  return 0;
+}
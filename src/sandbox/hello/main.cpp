@@ -49,9 +49,11 @@ class EcsDemo : public Game {
     MovementSystem movementSystem;
   public:
     Delegate<bool(SDL_Event&)> systemsHandlerDlgt;
+    Delegate<void(float)> tickDlgt;
     EcsDemo(int argc, char **argv)
         : Game(argc, argv, "Entity Component Sytem Demo"), wasdSystem(&state), movementSystem(&state) {
       systemsHandlerDlgt = DELEGATE(&EcsDemo::systemsHandler, this);
+      tickDlgt = DELEGATE(&EcsDemo::tick, this);
     }
     EcsResult init() {
       wasdSystem.init();
@@ -86,7 +88,7 @@ class EcsDemo : public Game {
       }
 
       entityId meshId = m_mesh->getId();
-      state.addPosition(meshId, {0.f, 0.f, -2.f});
+      state.addPosition(meshId, glm::vec3(0.f, 0.f, -2.f));
       state.addOrientation(meshId, glm::quat());
 
       return ECS_SUCCESS;
@@ -97,6 +99,7 @@ class EcsDemo : public Game {
     }
 
     void tick(float dt) {
+      wasdSystem.takeInputSnapshot();
       wasdSystem.tick(dt);
       movementSystem.tick(dt);
     }
@@ -104,9 +107,7 @@ class EcsDemo : public Game {
 
 void main_loop(void *instance) {
   EcsDemo *demo = (EcsDemo *) instance;
-  float dt;
-  demo->mainLoop(demo->systemsHandlerDlgt, dt);
-  demo->tick(dt);
+  demo->mainLoop(demo->systemsHandlerDlgt, demo->tickDlgt);
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+#include "glm/gtc/quaternion.hpp"
+#include "../../common/scene.h"
+#include "../../common/wasdCamera.h"
+#include "../../common/game.h"
+#include "../../common/meshObject.h"
+
+#include "../../common/ecs/ecsSystem_controls.h"
+
+using namespace ld2016;
+using namespace ecs;
+
+/*
+ * Draws a grid of the same textured mesh many times over, and reports the draw calls made and the time each frame
+ * takes once a second. Pass --instancing to batch the meshes into instanced draw calls (each is drawn on its own
+ * otherwise, for comparison), and a number to draw that many meshes instead of 10000.
+ */
+class InstancingDemo : public Game {
+  private:
+    std::shared_ptr<WasdCamera> m_camera;
+    std::vector<std::shared_ptr<MeshObject>> m_meshes;
+    ControlSystem wasdSystem;
+    int m_numMeshes;
+    Uint64 m_frameTime, m_lastFrameReport;
+    uint32_t m_frames;
+  public:
+    Delegate<bool(SDL_Event&)> systemsHandlerDlgt;
+    Delegate<void(float)> tickDlgt;
+    InstancingDemo(int argc, char **argv)
+        : Game(argc, argv, "Instancing Demo"), wasdSystem(&state), m_numMeshes(10000), m_frameTime(0),
+          m_lastFrameReport(0), m_frames(0) {
+      systemsHandlerDlgt = DELEGATE(&InstancingDemo::systemsHandler, this);
+      tickDlgt = DELEGATE(&InstancingDemo::tick, this);
+      for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--instancing") == 0) {
+          this->scene()->setInstancing(true);
+        } else if (atoi(argv[i]) > 0) {
+          m_numMeshes = atoi(argv[i]);
+        }
+      }
+      fprintf(stderr, "drawing %d meshes, instancing %s\n", m_numMeshes,
+              RenderQueue::instancingSupported() ? "supported" : "not supported");
+      setReportRenderStats(true);
+    }
+    EcsResult init() {
+      wasdSystem.init();
+
+      // Lay the meshes out in a square grid in front of the camera
+      int side = (int) ceil(sqrt((double) m_numMeshes));
+      float spacing = 3.0f;
+      m_camera = std::shared_ptr<WasdCamera>(
+          new WasdCamera( state,
+                          80.0f * ((float) M_PI / 180.0f),  // fovy
+                          0.1f,  // near
+                          100000.0f,  // far
+                          glm::vec3(0.0f, 0.0f, side * spacing * 0.5f),  // position
+                          glm::quat()  // orientation
+          ));
+      this->scene()->addObject(m_camera);
+      this->setCamera(m_camera);
+      for (int i = 0; i < m_numMeshes; ++i) {
+        glm::vec3 position((i % side - side * 0.5f) * spacing, (i / side - side * 0.5f) * spacing, 0.0f);
+        m_meshes.push_back(std::shared_ptr<MeshObject>(
+            new MeshObject(state, "assets/models/pyramid_bottom.dae", "assets/textures/pyramid_bottom.png",
+                           position)));
+        this->scene()->addObject(m_meshes.back());
+      }
+
+      return ECS_SUCCESS;
+    }
+
+    bool systemsHandler(SDL_Event& event) {
+      return wasdSystem.handleEvent(event);
+    }
+
+    void tick(float dt) {
+      wasdSystem.takeInputSnapshot();
+      wasdSystem.tick(dt);
+    }
+
+    void frame() {
+      Uint64 start = SDL_GetPerformanceCounter();
+      mainLoop(systemsHandlerDlgt, tickDlgt);
+      Uint64 end = SDL_GetPerformanceCounter();
+      m_frameTime += end - start;
+      ++m_frames;
+      if (end - m_lastFrameReport >= SDL_GetPerformanceFrequency()) {
+        fprintf(stderr, "average frame time: %.3f ms over %u frames\n",
+                1000.0 * (double) m_frameTime / (double) SDL_GetPerformanceFrequency() / m_frames, m_frames);
+        m_frameTime = 0;
+        m_frames = 0;
+        m_lastFrameReport = end;
+      }
+    }
+};
+
+void main_loop(void *instance) {
+  InstancingDemo *demo = (InstancingDemo *) instance;
+  demo->frame();
+}
+
+int main(int argc, char **argv) {
+  InstancingDemo demo(argc, argv);
+  EcsResult status = demo.init();
+  if (status.isError()) { fprintf(stderr, "%s", status.toString().c_str()); }
+
+#ifdef __EMSCRIPTEN__
+  emscripten_set_main_loop_arg(main_loop, (void*)&demo, 0, 1);
+#else
+  while (1) {
+    main_loop(&demo);
+  }
+#endif
+
+  return EXIT_SUCCESS;
+}
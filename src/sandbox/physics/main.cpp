@@ -21,13 +21,52 @@
  * IN THE SOFTWARE.
  */
 
+/*
+ * Headless physics benchmarks, without a window or GL context.
+ *
+ * scaling: spawns N entities (spheres, hulls or stacks of spheres) through ecs::State, steps them with PhysicsSystem
+ * exactly as the game does, for N from 100 up to maxEntities. For each N it reports per-step time percentiles, the
+ * broadphase pair and contact manifold counts, the memory taken by the scene and the number of heap allocations Bullet
+ * made during the second half of the steps (which should settle to zero), in a table on stderr and as a JSON array on
+ * stdout for tracking regressions.
+ *
+ * threads: measures how stepping a Bullet world scales with the number of threads it gets, on a few thousand spheres
+ * stacked in columns over a ground plane (slightly offset, so the stacks topple and keep the narrowphase and solver
+ * busy). With BULLET_MULTITHREADED (see the top-level CMakeLists.txt), each run builds the same
+ * btDiscreteDynamicsWorldMt that PhysicsSystem uses, its work spread across a jobs::WorkerPool through
+ * ecs::PhysicsTaskScheduler, and the runs sweep the thread count from 1 up to maxThreads. Without it only the
+ * single-threaded btDiscreteDynamicsWorld is measured.
+ *
+ * Usage: physics scaling [spheres|hulls|stacks] [steps] [maxEntities] [threads]
+ *        physics threads [spheres] [steps] [maxThreads]
+ */
+
 #include <btBulletDynamicsCommon.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
-#include "../../common/scene.h"
-// #include "../../common/wasdCamera.h"
+#include "../../common/ecs/ecsPhysicsTaskScheduler.h"
+#include "../../common/ecs/ecsSystem_physics.h"
+#include "../../common/jobs/jobsWorkerPool.h"
+#if BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
+
+#define SPHERE_RADIUS 0.5f
+#define SPHERES_PER_STACK 10
+#define STEP_LENGTH (1.0f / 60.0f)
+
+typedef std::chrono::high_resolution_clock Clock;
 
 /* Global physics data structures */
 btDispatcher *dispatcher;
@@ -35,38 +74,323 @@ btBroadphaseInterface *broadphase;
 btConstraintSolver *constraintSolver;
 btCollisionConfiguration *collisionConfiguration;
 btDynamicsWorld *dynamicsWorld;
+#if BT_THREADSAFE
+btConstraintSolverPoolMt *solverPool = nullptr;
+#endif
+
+btCollisionShape *groundShape;
+btCollisionShape *sphereShape;
+std::vector<btRigidBody *> bodies;
 
-void init_bullet() {
+void init_bullet(bool multithreaded, int numThreads) {
   collisionConfiguration = new btDefaultCollisionConfiguration();
-  dispatcher = new btCollisionDispatcher(collisionConfiguration);
   broadphase = new btDbvtBroadphase();
-  constraintSolver = new btSequentialImpulseConstraintSolver();
-  dynamicsWorld = new btDiscreteDynamicsWorld(
-      dispatcher,
-      broadphase,
-      constraintSolver,
-      collisionConfiguration);
+#if BT_THREADSAFE
+  if (multithreaded) {
+    dispatcher = new btCollisionDispatcherMt(collisionConfiguration);
+    solverPool = new btConstraintSolverPoolMt(numThreads);
+    constraintSolver = new btSequentialImpulseConstraintSolverMt();
+    dynamicsWorld = new btDiscreteDynamicsWorldMt(
+        dispatcher,
+        broadphase,
+        solverPool,
+        constraintSolver,
+        collisionConfiguration);
+  } else
+#endif
+  {
+    dispatcher = new btCollisionDispatcher(collisionConfiguration);
+    constraintSolver = new btSequentialImpulseConstraintSolver();
+    dynamicsWorld = new btDiscreteDynamicsWorld(
+        dispatcher,
+        broadphase,
+        constraintSolver,
+        collisionConfiguration);
+  }
   dynamicsWorld->setGravity(btVector3(0.0f, 0.0f, -9.81f));
 }
 
 void destroy_bullet() {
   delete dynamicsWorld;
   delete constraintSolver;
+#if BT_THREADSAFE
+  delete solverPool;
+  solverPool = nullptr;
+#endif
   delete broadphase;
   delete dispatcher;
   delete collisionConfiguration;
 }
 
-void main_loop() {
-  dynamicsWorld->stepSimulation(1.0f / 60.0f);
+void add_body(btCollisionShape *shape, float mass, const btVector3 &position) {
+  btVector3 inertia(0.f, 0.f, 0.f);
+  if (mass > 0.f) {
+    shape->calculateLocalInertia(mass, inertia);
+  }
+  btDefaultMotionState *motionState = new btDefaultMotionState(
+      btTransform(btQuaternion(0.f, 0.f, 0.f, 1.f), position));
+  btRigidBody::btRigidBodyConstructionInfo ci(mass, motionState, shape, inertia);
+  btRigidBody *body = new btRigidBody(ci);
+  body->setFriction(1.f);
+  dynamicsWorld->addRigidBody(body);
+  bodies.push_back(body);
 }
 
-int main(int argc, char **argv) {
-  init_bullet();
+/*
+ * Lays the spheres out in a square grid of stacks, each level nudged a little off the one below it
+ */
+void build_scene(int numSpheres) {
+  add_body(groundShape, 0.f, btVector3(0.f, 0.f, 0.f));
+  int numStacks = (numSpheres + SPHERES_PER_STACK - 1) / SPHERES_PER_STACK;
+  int side = 1;
+  while (side * side < numStacks) {
+    ++side;
+  }
+  float spacing = 2.f * SPHERE_RADIUS * 1.1f;
+  for (int i = 0; i < numSpheres; ++i) {
+    int stack = i / SPHERES_PER_STACK, level = i % SPHERES_PER_STACK;
+    float nudge = (level & 1 ? 0.05f : -0.05f) * SPHERE_RADIUS;
+    add_body(sphereShape, 1.f, btVector3(
+        (stack % side - side * 0.5f) * spacing + nudge,
+        (stack / side - side * 0.5f) * spacing,
+        SPHERE_RADIUS + level * 2.f * SPHERE_RADIUS));
+  }
+}
 
-  /* TODO: Actually run the simulation here */
+void destroy_scene() {
+  for (auto body : bodies) {
+    delete body->getMotionState();
+    delete body;
+  }
+  bodies.clear();
+}
 
+/*
+ * @return milliseconds per step
+ */
+double run(bool multithreaded, int numThreads, int numSpheres, int steps) {
+  init_bullet(multithreaded, numThreads);
+  build_scene(numSpheres);
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < steps; ++i) {
+    dynamicsWorld->stepSimulation(STEP_LENGTH, 1, STEP_LENGTH);
+  }
+  double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / steps;
+  // Deleting the world first drops every body from it in one pass (see PhysicsSystem::deInit)
   destroy_bullet();
+  destroy_scene();
+  return ms;
+}
+
+int threadSweep(int argc, char **argv) {
+  int numSpheres = argc > 1 ? atoi(argv[1]) : 4000;
+  int steps = argc > 2 ? atoi(argv[2]) : 300;
+  int maxThreads = argc > 3 ? atoi(argv[3]) : (int) jobs::WorkerPool::defaultNumWorkers() + 1;
+  numSpheres = numSpheres > 0 ? numSpheres : 1;
+  steps = steps > 0 ? steps : 1;
+  maxThreads = maxThreads > 0 ? maxThreads : 1;
+
+  groundShape = new btStaticPlaneShape(btVector3(0.f, 0.f, 1.f), 0.f);
+  sphereShape = new btSphereShape(SPHERE_RADIUS);
+
+  printf("%d spheres, %d steps\n", numSpheres, steps);
+  printf("%-12s %8s %12s %10s %12s\n", "world", "threads", "step(ms)", "speedup", "efficiency");
+  double oneThreadMs = run(false, 1, numSpheres, steps);
+  printf("%-12s %8d %12.3f %10.2f %11.0f%%\n", "discrete", 1, oneThreadMs, 1.0, 100.0);
+#if BT_THREADSAFE
+  // One pool for every run: Bullet gives each thread that calls into it an index for good, so a new pool per run
+  // would keep handing out higher ones. The task scheduler reports the whole pool to Bullet whatever setNumThreads
+  // was given (since any of the pool's threads may run a chunk), and only splits each loop into fewer chunks.
+  jobs::WorkerPool pool((uint32_t) maxThreads - 1);
+  ecs::PhysicsTaskScheduler taskScheduler(&pool);
+  btSetTaskScheduler(&taskScheduler);
+  for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads) {
+    taskScheduler.setNumThreads(threads);
+    double ms = run(true, threads, numSpheres, steps);
+    printf("%-12s %8d %12.3f %10.2f %11.0f%%\n", "discreteMt", threads, ms, oneThreadMs / ms,
+           100.0 * oneThreadMs / ms / threads);
+    if (threads == maxThreads) {
+      break;
+    }
+  }
+  btSetTaskScheduler(btGetSequentialTaskScheduler());
+#else
+  printf("(built without BULLET_MULTITHREADED, so there is nothing to sweep)\n");
+#endif
+
+  delete sphereShape;
+  delete groundShape;
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ * @return the resident memory of the process in bytes, or 0 where that can't be found out
+ */
+long residentBytes() {
+#ifdef __linux__
+  long pages = 0, resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(statm);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+enum SceneKind { SPHERES, HULLS, STACKS };
+
+struct ScalingResult {
+  int entities;
+  double setupMs, meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+  int pairs, manifolds;
+  long bytes;
+  uint64_t steadyAllocations; // heap allocations made by Bullet during the second half of the steps
+};
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+  size_t index = (size_t) (fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+/*
+ * Spreads the entities over a square grid, dropped from a little above the ground (or stacked, for STACKS), with a
+ * fixed pseudo-random jitter so that every run sees the same scene.
+ */
+ScalingResult runScaling(SceneKind kind, int numEntities, int steps, jobs::WorkerPool *pool) {
+  ScalingResult result;
+  result.entities = numEntities;
+  long bytesBefore = residentBytes();
+  Clock::time_point start = Clock::now();
+
+  ecs::State state;
+  ecs::PhysicsSystem physicsSystem(&state);
+  physicsSystem.setWorkerPool(pool);
+  physicsSystem.init();
 
+  float radius = SPHERE_RADIUS;
+  std::vector<float> hullPoints = {
+       SPHERE_RADIUS,  0.f,  0.f,   -SPHERE_RADIUS,  0.f,  0.f,
+       0.f,  SPHERE_RADIUS,  0.f,    0.f, -SPHERE_RADIUS,  0.f,
+       0.f,  0.f,  SPHERE_RADIUS,    0.f,  0.f, -SPHERE_RADIUS
+  };
+  int perColumn = kind == STACKS ? SPHERES_PER_STACK : 1;
+  int numColumns = (numEntities + perColumn - 1) / perColumn;
+  int side = 1;
+  while (side * side < numColumns) {
+    ++side;
+  }
+  float spacing = 2.f * SPHERE_RADIUS * (kind == STACKS ? 1.1f : 1.5f);
+  uint32_t seed = 12345;
+  for (int i = 0; i < numEntities; ++i) {
+    int column = i / perColumn, level = i % perColumn;
+    seed = seed * 1664525u + 1013904223u;
+    float jitter = ((float) (seed >> 8) / (float) (1u << 24) - 0.5f) * 0.1f * SPHERE_RADIUS;
+    float height = kind == STACKS ? SPHERE_RADIUS + level * 2.f * SPHERE_RADIUS : 2.f * SPHERE_RADIUS + jitter;
+    ecs::entityId id;
+    state.createEntity(&id);
+    state.add<ecs::Position>(id, glm::vec3(
+        (column % side - side * 0.5f) * spacing + jitter,
+        (column / side - side * 0.5f) * spacing,
+        height));
+    state.add<ecs::Orientation>(id, glm::quat());
+    if (kind == HULLS) {
+      state.add<ecs::Physics>(id, 1.f, (void *) &hullPoints, ecs::Physics::MESH);
+    } else {
+      state.add<ecs::Physics>(id, 1.f, (void *) &radius, ecs::Physics::SPHERE);
+    }
+  }
+  result.setupMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  result.bytes = residentBytes() - bytesBefore;
+
+  std::vector<double> stepMs(steps);
+  double totalMs = 0.0;
+  uint64_t allocationsAtHalf = 0;
+  for (int i = 0; i < steps; ++i) {
+    if (i == steps / 2) {
+      allocationsAtHalf = physicsSystem.getAllocationStats().bulletAllocations;
+    }
+    Clock::time_point stepStart = Clock::now();
+    physicsSystem.tick(STEP_LENGTH);
+    stepMs[i] = std::chrono::duration<double, std::milli>(Clock::now() - stepStart).count();
+    totalMs += stepMs[i];
+  }
+  result.steadyAllocations = physicsSystem.getAllocationStats().bulletAllocations - allocationsAtHalf;
+  btDynamicsWorld *world = physicsSystem.getDynamicsWorld();
+  result.pairs = world->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs();
+  result.manifolds = world->getDispatcher()->getNumManifolds();
+  physicsSystem.deInit();
+
+  std::sort(stepMs.begin(), stepMs.end());
+  result.meanMs = totalMs / steps;
+  result.p50Ms = percentile(stepMs, 0.5);
+  result.p90Ms = percentile(stepMs, 0.9);
+  result.p99Ms = percentile(stepMs, 0.99);
+  result.maxMs = stepMs.back();
+  return result;
+}
+
+int scaling(int argc, char **argv) {
+  const char *kindNames[] = { "spheres", "hulls", "stacks" };
+  SceneKind kind = SPHERES;
+  if (argc > 1) {
+    for (int i = 0; i < 3; ++i) {
+      if (strcmp(argv[1], kindNames[i]) == 0) {
+        kind = (SceneKind) i;
+      }
+    }
+  }
+  int steps = argc > 2 ? atoi(argv[2]) : 300;
+  int maxEntities = argc > 3 ? atoi(argv[3]) : 50000;
+  int threads = argc > 4 ? atoi(argv[4]) : 1;
+  steps = steps > 0 ? steps : 1;
+  threads = threads > 0 ? threads : 1;
+#if !BT_THREADSAFE
+  if (threads > 1) {
+    fprintf(stderr, "(built without BULLET_MULTITHREADED, so stepping on one thread)\n");
+    threads = 1;
+  }
+#endif
+  jobs::WorkerPool *pool = threads > 1 ? new jobs::WorkerPool((uint32_t) threads - 1) : nullptr;
+
+  const int counts[] = { 100, 500, 1000, 5000, 10000, 50000 };
+  fprintf(stderr, "%s, %d steps, %d thread(s)\n", kindNames[kind], steps, threads);
+  fprintf(stderr, "%9s %10s %9s %9s %9s %9s %9s %8s %9s %9s %7s\n", "entities", "setup(ms)", "mean(ms)", "p50(ms)",
+          "p90(ms)", "p99(ms)", "max(ms)", "pairs", "manifolds", "mem(KiB)", "allocs");
+  printf("[\n");
+  bool first = true;
+  for (int count : counts) {
+    if (count > maxEntities) {
+      break;
+    }
+    ScalingResult r = runScaling(kind, count, steps, pool);
+    fprintf(stderr, "%9d %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f %8d %9d %9ld %7llu\n", r.entities, r.setupMs, r.meanMs,
+            r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs, r.pairs, r.manifolds, r.bytes / 1024,
+            (unsigned long long) r.steadyAllocations);
+    printf("%s  {\"scene\": \"%s\", \"entities\": %d, \"steps\": %d, \"threads\": %d, \"setup_ms\": %.3f, "
+           "\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+           "\"pairs\": %d, \"manifolds\": %d, \"bytes\": %ld, \"steady_allocations\": %llu}",
+           first ? "" : ",\n", kindNames[kind], r.entities, steps, threads, r.setupMs, r.meanMs, r.p50Ms, r.p90Ms,
+           r.p99Ms, r.maxMs, r.pairs, r.manifolds, r.bytes, (unsigned long long) r.steadyAllocations);
+    first = false;
+  }
+  printf("\n]\n");
+  delete pool;
   return EXIT_SUCCESS;
 }
+
+int main(int argc, char **argv) {
+  bool threads = argc > 1 && strcmp(argv[1], "threads") == 0;
+  bool scale = argc > 1 && strcmp(argv[1], "scaling") == 0;
+  if (!threads && !scale) {
+    fprintf(stderr, "Usage: physics scaling [spheres|hulls|stacks] [steps] [maxEntities] [threads]\n"
+                    "       physics threads [spheres] [steps] [maxThreads]\n");
+    return EXIT_FAILURE;
+  }
+  return threads ? threadSweep(argc - 1, argv + 1) : scaling(argc - 1, argv + 1);
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2016 Galen Cochrane
+ * Galen Cochrane <galencochrane@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Bakes the collision geometry of a mesh into a hull file (see ecsHullFile.h) for Physics::HULL_FILE entities.
+ *
+ * By default the whole mesh becomes a single convex hull, reduced with btShapeHull and then cut down to at most
+ * --max-vertices points (keeping the points that are farthest apart). With --parts, the mesh is first split into its
+ * pieces (every mesh in the file, and every set of triangles connected to each other within a mesh), and each piece
+ * gets its own hull. The game loads those as one btCompoundShape, which fits meshes built out of convex pieces far
+ * better than a single hull does.
+ *
+ * Usage: hullBaker [--parts] [--max-vertices n] input.dae output.hull
+ */
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionShapes/btShapeHull.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../../common/ecs/ecsHullFile.h"
+
+#define DEFAULT_MAX_VERTICES 32
+
+using ecs::HullPoints;
+
+/*
+ * Splits the triangles of 'mesh' into sets that share vertices, and collects the vertices of each set
+ */
+static void splitConnected(const aiMesh* mesh, std::vector<HullPoints>* parts) {
+  std::vector<unsigned> parent(mesh->mNumVertices);
+  for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+    parent[i] = i;
+  }
+  struct Find {
+    static unsigned root(std::vector<unsigned>& parent, unsigned i) {
+      while (parent[i] != i) {
+        i = parent[i] = parent[parent[i]];
+      }
+      return i;
+    }
+  };
+  for (unsigned f = 0; f < mesh->mNumFaces; ++f) {
+    const aiFace& face = mesh->mFaces[f];
+    for (unsigned j = 1; j < face.mNumIndices; ++j) {
+      parent[Find::root(parent, face.mIndices[j])] = Find::root(parent, face.mIndices[0]);
+    }
+  }
+  std::vector<int> partOf(mesh->mNumVertices, -1);
+  for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+    unsigned root = Find::root(parent, i);
+    if (partOf[root] < 0) {
+      partOf[root] = (int) parts->size();
+      parts->push_back(HullPoints());
+    }
+    HullPoints& points = (*parts)[partOf[root]];
+    points.push_back(mesh->mVertices[i].x);
+    points.push_back(mesh->mVertices[i].y);
+    points.push_back(mesh->mVertices[i].z);
+  }
+}
+
+/*
+ * Keeps at most 'maxVertices' of 'points': first the one farthest from their centre, then over and over the one
+ * farthest from all of those kept so far, so that the extremes of the shape survive.
+ */
+static HullPoints keepFarthest(const HullPoints& points, int maxVertices) {
+  int numPoints = (int) points.size() / 3;
+  if (numPoints <= maxVertices) {
+    return points;
+  }
+  std::vector<btVector3> all(numPoints);
+  btVector3 centre(0.f, 0.f, 0.f);
+  for (int i = 0; i < numPoints; ++i) {
+    all[i] = btVector3(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+    centre += all[i];
+  }
+  centre /= (btScalar) numPoints;
+  std::vector<btScalar> distance(numPoints); // squared distance to the nearest point kept so far
+  for (int i = 0; i < numPoints; ++i) {
+    distance[i] = all[i].distance2(centre);
+  }
+  HullPoints kept;
+  for (int k = 0; k < maxVertices; ++k) {
+    int farthest = 0;
+    for (int i = 1; i < numPoints; ++i) {
+      if (distance[i] > distance[farthest]) {
+        farthest = i;
+      }
+    }
+    kept.push_back(all[farthest].x());
+    kept.push_back(all[farthest].y());
+    kept.push_back(all[farthest].z());
+    for (int i = 0; i < numPoints; ++i) {
+      btScalar d = all[i].distance2(all[farthest]);
+      distance[i] = d < distance[i] ? d : distance[i];
+    }
+  }
+  return kept;
+}
+
+/*
+ * @return the points of a simplified convex hull around 'points'
+ */
+static HullPoints bakeHull(const HullPoints& points, int maxVertices) {
+  btConvexHullShape raw(points.data(), (int) points.size() / 3, 3 * sizeof(float));
+  btShapeHull hull(&raw);
+  hull.buildHull(raw.getMargin()); // shrunk by the margin, which Bullet adds back on when colliding
+  HullPoints baked;
+  for (int i = 0; i < hull.numVertices(); ++i) {
+    const btVector3& vertex = hull.getVertexPointer()[i];
+    baked.push_back(vertex.x());
+    baked.push_back(vertex.y());
+    baked.push_back(vertex.z());
+  }
+  return keepFarthest(baked, maxVertices);
+}
+
+static void usage() {
+  fprintf(stderr, "Usage: hullBaker [--parts] [--max-vertices n] input.dae output.hull\n");
+}
+
+int main(int argc, char **argv) {
+  bool parts = false;
+  int maxVertices = DEFAULT_MAX_VERTICES;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--parts") == 0) {
+      parts = true;
+    } else if (strcmp(argv[i], "--max-vertices") == 0 && i + 1 < argc) {
+      maxVertices = atoi(argv[++i]);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.size() != 2 || maxVertices < 4) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  Assimp::Importer importer;
+  // Joining identical vertices is what lets triangles that touch be told apart from ones that don't
+  const aiScene* scene = importer.ReadFile(files[0], aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+  if (!scene || scene->mNumMeshes == 0) {
+    fprintf(stderr, "Failed to load mesh from file: '%s'\n", files[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<HullPoints> pieces;
+  for (unsigned m = 0; m < scene->mNumMeshes; ++m) {
+    const aiMesh* mesh = scene->mMeshes[m];
+    if (parts) {
+      splitConnected(mesh, &pieces);
+      continue;
+    }
+    if (pieces.empty()) {
+      pieces.push_back(HullPoints());
+    }
+    for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+      pieces[0].push_back(mesh->mVertices[i].x);
+      pieces[0].push_back(mesh->mVertices[i].y);
+      pieces[0].push_back(mesh->mVertices[i].z);
+    }
+  }
+
+  std::vector<HullPoints> hulls;
+  for (auto& piece : pieces) {
+    if (piece.size() < 3 * 4) {
+      continue; // too few points to enclose any volume
+    }
+    hulls.push_back(bakeHull(piece, maxVertices));
+    printf("hull %u: %u points -> %u\n", (unsigned) hulls.size() - 1, (unsigned) piece.size() / 3,
+           (unsigned) hulls.back().size() / 3);
+  }
+  if (hulls.empty()) {
+    fprintf(stderr, "No hulls could be made from '%s'\n", files[0]);
+    return EXIT_FAILURE;
+  }
+  return ecs::saveHullFile(files[1], hulls) ? EXIT_SUCCESS : EXIT_FAILURE;
+}